@@ -0,0 +1,58 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * APDU capture in pcap format (GSMTAP SIM encapsulation)
+ *
+ * Every APDU processed by softsim_transact() is appended to a RAM buffer
+ * as one pcap record holding an IPv4/UDP/GSMTAP packet, type SIM, whose
+ * payload is the C-APDU followed by the R-APDU. Wireshark decodes it with
+ * the GSM SIM dissector.
+ */
+
+#ifndef SOFTSIM_APDU_PCAP_H_
+#define SOFTSIM_APDU_PCAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get the capture as a complete pcap stream.
+ *
+ * The buffer starts with the pcap global header and is only ever
+ * appended to until softsim_apdu_pcap_clear() is called.
+ *
+ * @param buf  Set to the start of the capture.
+ *
+ * @return Length of the capture in bytes.
+ */
+size_t softsim_apdu_pcap_get(const uint8_t **buf);
+
+/** @brief Number of APDUs not captured because the buffer was full. */
+uint32_t softsim_apdu_pcap_dropped(void);
+
+/** @brief Restart the capture from an empty pcap stream. */
+void softsim_apdu_pcap_clear(void);
+
+/**
+ * @brief Write the capture to a file through the Zephyr FS API.
+ *
+ * On native_sim this is typically a host directory mounted with
+ * CONFIG_FUSE_FS_ACCESS or a host-backed flash simulator.
+ *
+ * @param path  Destination file, truncated if it exists.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int softsim_apdu_pcap_save(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_APDU_PCAP_H_ */
@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * APDU latency histograms and per-INS profiling counters
+ *
+ * softsim_transact() measures every APDU in hardware cycles and accounts
+ * it to the class of its INS byte, together with the time spent in the
+ * NVS storage calls it triggered.
+ */
+
+#ifndef SOFTSIM_APDU_STATS_H_
+#define SOFTSIM_APDU_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Histogram buckets are powers of two in microseconds: bucket 0 counts
+ * APDUs below 64 us, bucket n counts [32 << n, 64 << n) us and the last
+ * bucket everything above.
+ */
+#define SOFTSIM_APDU_STATS_BUCKETS 14
+
+/** Counters for one INS class */
+struct softsim_apdu_stats_ins {
+    const char *name;          /* Command name, "OTHER" for unlisted INS */
+    uint8_t ins;               /* INS byte, 0 for OTHER */
+    uint32_t count;            /* Number of APDUs */
+    uint32_t over_budget;      /* APDUs above CONFIG_SOFTSIM_APDU_STATS_BUDGET_US */
+    uint64_t cycles_total;     /* Total time in ss_transact() */
+    uint32_t cycles_min;
+    uint32_t cycles_max;
+    uint64_t storage_cycles;   /* Part of cycles_total spent in storage calls */
+    uint32_t hist[SOFTSIM_APDU_STATS_BUCKETS];
+};
+
+/** Counters for one kind of storage call */
+struct softsim_storage_stats {
+    const char *name;          /* "read", "write" or "delete" */
+    uint32_t count;
+    uint64_t cycles_total;
+    uint32_t cycles_max;
+};
+
+/**
+ * @brief Number of INS classes, including the trailing OTHER class.
+ */
+size_t softsim_apdu_stats_ins_count(void);
+
+/**
+ * @brief Copy the counters of one INS class.
+ *
+ * @param idx  Class index, below softsim_apdu_stats_ins_count().
+ * @param out  Destination.
+ *
+ * @return 0 on success, -EINVAL if @p idx is out of range.
+ */
+int softsim_apdu_stats_ins_get(size_t idx, struct softsim_apdu_stats_ins *out);
+
+/**
+ * @brief Number of storage call kinds.
+ */
+size_t softsim_storage_stats_count(void);
+
+/**
+ * @brief Copy the counters of one kind of storage call.
+ *
+ * @param idx  Kind index, below softsim_storage_stats_count().
+ * @param out  Destination.
+ *
+ * @return 0 on success, -EINVAL if @p idx is out of range.
+ */
+int softsim_storage_stats_get(size_t idx, struct softsim_storage_stats *out);
+
+/** @brief Clear all APDU and storage counters. */
+void softsim_apdu_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_APDU_STATS_H_ */
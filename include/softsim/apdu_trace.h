@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Binary APDU trace ring buffer
+ *
+ * Keeps a fixed number of compact records about the last APDUs processed
+ * by softsim_transact(). Recording is lock-free and costs a few stores
+ * per APDU, so it can stay enabled in production builds.
+ */
+
+#ifndef SOFTSIM_APDU_TRACE_H_
+#define SOFTSIM_APDU_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Magic value marking a valid ring ("SAPT") */
+#define SOFTSIM_APDU_TRACE_MAGIC 0x53415054
+
+/** One APDU record, 24 bytes */
+struct softsim_apdu_trace_entry {
+    uint32_t seq;              /* Sequence number, 0 = never written */
+    uint32_t timestamp;        /* Uptime in ms when the APDU completed */
+    uint32_t cycles;           /* Latency in hardware cycles */
+    uint8_t hdr[4];            /* CLA INS P1 P2 */
+    uint16_t lc;               /* Command data length */
+    uint16_t rsp_len;          /* Response data length (without SW) */
+    uint16_t sw;               /* Status word */
+    uint16_t reserved;
+};
+
+/**
+ * @brief Copy the recorded APDUs, oldest first.
+ *
+ * Entries being overwritten while copying are skipped.
+ *
+ * @param out  Destination array.
+ * @param max  Number of entries in @p out.
+ *
+ * @return Number of entries copied.
+ */
+size_t softsim_apdu_trace_get(struct softsim_apdu_trace_entry *out, size_t max);
+
+/** @brief Drop all recorded APDUs. */
+void softsim_apdu_trace_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_APDU_TRACE_H_ */
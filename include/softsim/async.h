@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Asynchronous APDU transaction service
+ *
+ * Requests are copied into a fixed pool and processed in order by a
+ * dedicated work queue, so callers such as the modem library callback
+ * return immediately and flash accesses happen in the softsim thread.
+ */
+
+#ifndef SOFTSIM_ASYNC_H_
+#define SOFTSIM_ASYNC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ss_context;
+
+/**
+ * @brief Completion callback, called from the softsim work queue.
+ *
+ * @param err        0 on success, negative errno otherwise.
+ * @param rsp        Response data followed by SW1 SW2. Only valid for the
+ *                   duration of the call.
+ * @param rsp_len    Response length.
+ * @param user_data  As passed to softsim_async_submit().
+ */
+typedef void (*softsim_async_cb_t)(int err, const uint8_t *rsp, size_t rsp_len,
+                                   void *user_data);
+
+/**
+ * @brief Queue one C-APDU for processing.
+ *
+ * The command is copied, @p req may be released as soon as this returns.
+ *
+ * @param ctx        Soft SIM context from ss_new_ctx().
+ * @param req        Command APDU.
+ * @param req_len    Command length, at most SOFTSIM_APDU_CMD_MAX.
+ * @param cb         Completion callback.
+ * @param user_data  Passed to @p cb.
+ *
+ * @retval 0 Request queued.
+ * @retval -EINVAL Invalid argument.
+ * @retval -ENOBUFS All CONFIG_SOFTSIM_ASYNC_QUEUE_DEPTH slots are in use.
+ */
+int softsim_async_submit(struct ss_context *ctx, const uint8_t *req, size_t req_len,
+                         softsim_async_cb_t cb, void *user_data);
+
+/**
+ * @brief Work queue running the soft SIM.
+ *
+ * Other soft SIM operations (reset, provisioning, ...) can be submitted
+ * here to be serialised with the APDUs.
+ */
+struct k_work_q *softsim_async_queue(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_ASYNC_H_ */
@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Per-file persistence policy of the soft SIM storage
+ *
+ * Files are matched by FID ("6f7e") or by path suffix ("7fff/6f7e"). Rules
+ * set at runtime take precedence over CONFIG_SOFTSIM_FS_VOLATILE and
+ * CONFIG_SOFTSIM_FS_WRITE_BACK; other files are written through.
+ */
+
+#ifndef SOFTSIM_FS_POLICY_H_
+#define SOFTSIM_FS_POLICY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum softsim_fs_policy {
+    /** Written to flash by ss_fclose() */
+    SOFTSIM_FS_WRITE_THROUGH,
+    /** Kept in RAM, written to flash later or by softsim_fs_sync() */
+    SOFTSIM_FS_WRITE_BACK,
+    /** Kept in RAM only, the flash content comes back after a reboot */
+    SOFTSIM_FS_VOLATILE,
+};
+
+/**
+ * @brief Set the policy of the files matching @p match.
+ *
+ * Security state (SQN, PIN and PUK counters, keys) stays write-through:
+ * a rule matching one of those files can only be write-through.
+ *
+ * @param match   FID or path suffix, e.g. "6f7e" or "7fff/6f7e".
+ * @param policy  Policy for the matching files.
+ *
+ * @retval 0        Rule set.
+ * @retval -EINVAL  @p match empty or too long.
+ * @retval -EPERM   @p match covers security state and @p policy is not
+ *                  write-through.
+ * @retval -ENOMEM  No free rule.
+ */
+int softsim_fs_policy_set(const char *match, enum softsim_fs_policy policy);
+
+/**
+ * @brief Write pending write-back files to flash now.
+ *
+ * Also saves the wear counters of CONFIG_SOFTSIM_WEAR_STATS if they
+ * changed. Call before a planned power off.
+ *
+ * @return 0 or the first storage error.
+ */
+int softsim_fs_sync(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_FS_POLICY_H_ */
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Dedicated soft SIM heap
+ *
+ * With CONFIG_SOFTSIM_HEAP the UICC library and the storage backend
+ * allocate from a k_heap of their own instead of the system heap, and
+ * with CONFIG_SOFTSIM_ARENA from a per-APDU arena while an APDU runs.
+ * Heap allocation and free counters do not include arena allocations.
+ */
+
+#ifndef SOFTSIM_HEAP_H_
+#define SOFTSIM_HEAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Soft SIM heap usage */
+struct softsim_heap_stats {
+    size_t size;               /* CONFIG_SOFTSIM_HEAP_SIZE */
+    size_t used;               /* Bytes currently allocated */
+    size_t max_used;           /* High-water mark of used */
+    uint32_t allocs;           /* Successful allocations */
+    uint32_t frees;
+    uint32_t failures;         /* Allocations that returned NULL */
+    uint32_t arena_allocs;     /* Served by the per-APDU arena */
+    uint32_t arena_fallbacks;  /* Did not fit in the arena */
+    uint32_t arena_pinned;     /* APDUs that left arena allocations behind */
+};
+
+/**
+ * @brief Get the soft SIM heap usage.
+ *
+ * @param out  Destination.
+ */
+void softsim_heap_stats_get(struct softsim_heap_stats *out);
+
+/**
+ * @brief Restart the high-water mark from the current usage and clear
+ *        the counters.
+ */
+void softsim_heap_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_HEAP_H_ */
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Concurrent soft SIM instances
+ *
+ * Each instance has its own file handles and NVS ID ranges in the shared
+ * storage partition, so two contexts can serve two modem slots from
+ * different threads. The storage calls of the UICC library carry no
+ * context: the instance is the one bound to the calling thread.
+ * softsim_transact() and the reset helpers bind the thread to the
+ * instance of their context for the duration of the call.
+ */
+
+#ifndef SOFTSIM_INSTANCE_H_
+#define SOFTSIM_INSTANCE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ss_context;
+
+/**
+ * @brief Create a soft SIM context for an instance.
+ *
+ * Use instead of ss_new_ctx(): the context is registered with
+ * @p instance, and the files loaded while creating it come from the
+ * storage of that instance.
+ *
+ * @param instance  Instance index, below CONFIG_SOFTSIM_INSTANCES.
+ *
+ * @return New context, NULL on error.
+ */
+struct ss_context *softsim_instance_new_ctx(unsigned int instance);
+
+/**
+ * @brief Free a context created by softsim_instance_new_ctx().
+ *
+ * @param ctx  Soft SIM context.
+ *
+ * @retval 0        Freed.
+ * @retval -ENOMEM  No free thread binding, @p ctx is left untouched.
+ */
+int softsim_instance_free_ctx(struct ss_context *ctx);
+
+/**
+ * @brief Bind the calling thread to an instance.
+ *
+ * Needed only for direct storage API calls, e.g. provisioning the files
+ * of an instance. Threads that are not bound use instance 0. Bindings do
+ * not nest: call softsim_instance_unbind() before binding the thread to
+ * another instance.
+ *
+ * @param instance  Instance index.
+ *
+ * @retval 0        Bound.
+ * @retval -EINVAL  No such instance.
+ * @retval -EBUSY   The calling thread is already bound.
+ * @retval -ENOMEM  No free binding slot.
+ */
+int softsim_instance_bind(unsigned int instance);
+
+/**
+ * @brief Release the binding of the calling thread.
+ */
+void softsim_instance_unbind(void);
+
+/**
+ * @brief Get the instance of a context.
+ *
+ * @param ctx  Soft SIM context.
+ *
+ * @return Instance index, 0 for contexts created by ss_new_ctx().
+ */
+unsigned int softsim_instance_of(struct ss_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_INSTANCE_H_ */
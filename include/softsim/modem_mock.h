@@ -0,0 +1,50 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Mock nRF modem softsim layer
+ *
+ * Implements the nrfxlib softsim functions used by the built-in modem
+ * glue and lets tests or benchmarks play the modem side on native_sim.
+ */
+
+#ifndef SOFTSIM_MODEM_MOCK_H_
+#define SOFTSIM_MODEM_MOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <nrf_modem_softsim.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Send one softsim request as the modem would and wait for the reply.
+ *
+ * The request data is copied into a heap buffer which the handler releases
+ * with nrf_modem_softsim_data_free(), like modem shared memory.
+ *
+ * @param cmd       Request type.
+ * @param data      Request payload (APDU), may be NULL.
+ * @param data_len  Payload length.
+ * @param rsp       Buffer for the response payload (ATR or R-APDU).
+ * @param rsp_size  Size of @p rsp.
+ * @param timeout   How long to wait for nrf_modem_softsim_res().
+ *
+ * @return Response length on success, -EIO if the handler answered with
+ *         nrf_modem_softsim_err(), -EAGAIN on timeout, other negative errno
+ *         otherwise.
+ */
+int softsim_modem_mock_request(enum nrf_modem_softsim_cmd cmd, const uint8_t *data,
+                               uint16_t data_len, uint8_t *rsp, size_t rsp_size,
+                               k_timeout_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_MODEM_MOCK_H_ */
@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Built-in nRF modem softsim glue
+ *
+ * With CONFIG_SOFTSIM_NRF_MODEM the module registers its own softsim
+ * request handler with the modem library and answers INIT, RESET, APDU
+ * and DEINIT requests from a soft SIM context it owns.
+ */
+
+#ifndef SOFTSIM_NRF_MODEM_H_
+#define SOFTSIM_NRF_MODEM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ss_context;
+
+/**
+ * @brief Soft SIM context served to the modem.
+ *
+ * Created on the first INIT request from the modem, or by this call if
+ * the application needs it earlier (e.g. to provision files).
+ *
+ * @return The context, NULL if it could not be allocated.
+ */
+struct ss_context *softsim_nrf_modem_ctx(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_NRF_MODEM_H_ */
@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * SIM profile selection
+ *
+ * Each profile lives in its own NVS ID range of the storage partition.
+ * Switching only changes which range the file paths map to; the files of
+ * the other profiles stay in place.
+ */
+
+#ifndef SOFTSIM_PROFILE_H_
+#define SOFTSIM_PROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Select the active SIM profile.
+ *
+ * The choice is persisted and restored at the next mount. The UICC
+ * context keeps the state loaded from the previous profile: follow with
+ * softsim_cold_reset() and a modem SIM reset.
+ *
+ * Files are provisioned into a profile by selecting it first, then
+ * writing them through the storage API as usual.
+ *
+ * @param profile  Profile index, below CONFIG_SOFTSIM_PROFILES.
+ *
+ * @retval 0        Profile active.
+ * @retval -EINVAL  No such profile.
+ * @retval -EBUSY   Files are open.
+ * @retval <0       Storage error.
+ */
+int softsim_profile_select(unsigned int profile);
+
+/**
+ * @brief Get the active SIM profile index.
+ */
+unsigned int softsim_profile_active(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_PROFILE_H_ */
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Storage snapshot export and import
+ *
+ * A snapshot holds every file of the active profile in one blob:
+ *
+ *   "SSNP" version(1) 0(1) count(2)
+ *   count x { id(2) len(2) data(len) }     id relative to the profile
+ *   crc32(4)                               IEEE, over everything before
+ *
+ * Integers are little endian. IDs are relative to the profile range, so a
+ * snapshot can be restored into another profile or instance.
+ */
+
+#ifndef SOFTSIM_SNAPSHOT_H_
+#define SOFTSIM_SNAPSHOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Receives the snapshot in chunks, returns 0 or a negative error */
+typedef int (*softsim_snapshot_out_t)(const uint8_t *data, size_t len, void *user);
+
+/**
+ * @brief Serialise the active profile of the calling thread's instance.
+ *
+ * @param out   Called with consecutive chunks of the snapshot.
+ * @param user  Passed to @p out.
+ *
+ * @return Snapshot size, or a negative error (storage or from @p out).
+ */
+int softsim_snapshot_export(softsim_snapshot_out_t out, void *user);
+
+struct softsim_snapshot_import;
+
+/**
+ * @brief Start restoring a snapshot into the active profile.
+ *
+ * The files are staged in a spare NVS range of the instance; the active
+ * profile is not modified before softsim_snapshot_import_end().
+ *
+ * @return Import state, NULL if files are open, memory is short or the
+ *         spare range could not be cleared.
+ */
+struct softsim_snapshot_import *softsim_snapshot_import_begin(void);
+
+/**
+ * @brief Feed the next chunk of a snapshot, of any size.
+ *
+ * Each file is written to the spare range as soon as it is complete.
+ *
+ * @retval 0        Chunk consumed.
+ * @retval -EBADMSG Malformed snapshot.
+ * @retval <0       Storage error.
+ */
+int softsim_snapshot_import_feed(struct softsim_snapshot_import *imp,
+                                 const uint8_t *data, size_t len);
+
+/**
+ * @brief Finish an import and release its state.
+ *
+ * Once the checksum is verified, the spare range becomes the active
+ * profile with a single NVS write, and the previous content is deleted.
+ * On any error, including a truncated snapshot, the profile is left
+ * untouched and the staged files are deleted.
+ *
+ * @return Number of files restored, or a negative error (-EBUSY if files
+ *         were opened meanwhile).
+ */
+int softsim_snapshot_import_end(struct softsim_snapshot_import *imp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_SNAPSHOT_H_ */
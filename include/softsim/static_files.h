@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Static SIM files packed at build time
+ *
+ * With CONFIG_SOFTSIM_STATIC_FILES_BIN the default profile of
+ * ss_static_files_hex.c is converted by scripts/gen_static_files.py into
+ * one const blob and an index sorted by path. The content is read in
+ * place from flash.
+ */
+
+#ifndef SOFTSIM_STATIC_FILES_H_
+#define SOFTSIM_STATIC_FILES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Index entry of a static file */
+struct softsim_static_file {
+    const char *name;          /* Path below the storage path, e.g. "3f00/2fe2" */
+    uint32_t offset;           /* Offset of the content in softsim_static_blob */
+    uint32_t len;              /* Content length */
+};
+
+/* Generated tables, the index is sorted by name */
+extern const uint8_t softsim_static_blob[];
+extern const struct softsim_static_file softsim_static_files[];
+extern const size_t softsim_static_files_count;
+/* CRC-32 of the blob and the index, changes with any file */
+extern const uint32_t softsim_static_files_hash;
+
+/**
+ * @brief Look up a static file.
+ *
+ * @param name  Path below the storage path, without leading '/'.
+ * @param len   Set to the content length when found.
+ *
+ * @return Pointer to the content in flash, NULL if there is no such file.
+ */
+const uint8_t *softsim_static_file_get(const char *name, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_STATIC_FILES_H_ */
@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Background garbage collection of the soft SIM storage
+ *
+ * With CONFIG_SOFTSIM_GC a low priority thread does this on its own once
+ * APDUs stop. Applications that know better when the modem is idle
+ * (e.g. entering PSM) can call softsim_storage_gc() themselves.
+ */
+
+#ifndef SOFTSIM_STORAGE_GC_H_
+#define SOFTSIM_STORAGE_GC_H_
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Garbage collect the NVS partition ahead of foreground writes.
+ *
+ * Moves to the next sector, collecting the oldest one, when less than
+ * CONFIG_SOFTSIM_GC_HEADROOM bytes fit in the write sector.
+ *
+ * @param force  Move to the next sector whatever the room left.
+ *
+ * @retval 1   Collected.
+ * @retval 0   Enough room, or collecting would not free enough.
+ * @retval <0  Storage error.
+ */
+int softsim_storage_gc(bool force);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_STORAGE_GC_H_ */
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Zephyr transaction layer for onomondo-uicc
+ *
+ * softsim_transact() is a drop-in replacement for ss_transact() which
+ * also feeds the module diagnostics (APDU trace, ...) enabled in Kconfig.
+ * softsim_atr() and the reset helpers let modem glue answer resets
+ * without rebuilding state that has not changed.
+ */
+
+#ifndef SOFTSIM_TRANSACT_H_
+#define SOFTSIM_TRANSACT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ss_context;
+
+/* Largest short APDUs: CLA INS P1 P2 Lc 255 bytes Le, and 256 bytes + SW */
+#define SOFTSIM_APDU_CMD_MAX 261
+#define SOFTSIM_APDU_RSP_MAX 258
+
+/**
+ * @brief Process one C-APDU and build the R-APDU.
+ *
+ * Same contract as ss_transact(): @p rsp receives the response data
+ * followed by SW1 SW2 and the returned value is the response length.
+ *
+ * @param ctx      Soft SIM context from ss_new_ctx().
+ * @param rsp      Response buffer.
+ * @param rsp_len  Size of @p rsp.
+ * @param req      Command APDU.
+ * @param req_len  In: command length. Out: as updated by ss_transact().
+ *
+ * @return Response length in bytes (including status word). The response
+ *         is 6F00 when the calling thread cannot be bound to the instance
+ *         of @p ctx (CONFIG_SOFTSIM_INSTANCE_THREADS exhausted).
+ */
+size_t softsim_transact(struct ss_context *ctx, uint8_t *rsp, size_t rsp_len,
+                        uint8_t *req, size_t *req_len);
+
+/**
+ * @brief Get the ATR, computed on first use and cached.
+ *
+ * The ATR only depends on the UICC library build, so it is shared by
+ * all contexts and served from RAM on every reset.
+ *
+ * @param ctx  Soft SIM context, used for the first computation only.
+ * @param atr  Set to the cached ATR.
+ *
+ * @return ATR length, 0 if it could not be computed.
+ */
+size_t softsim_atr(struct ss_context *ctx, const uint8_t **atr);
+
+/**
+ * @brief Warm reset of the UICC.
+ *
+ * ss_reset() of the library: closes logical channels and resets the
+ * selection state, as required after a modem RESET. It also drops the
+ * responses cached for the context. It is not faster than ss_reset()
+ * by itself. The time saved comes from CONFIG_SOFTSIM_FILE_CACHE: the
+ * files it holds are kept, so the file system walk that follows does
+ * not hit flash.
+ *
+ * @param ctx  Soft SIM context.
+ */
+void softsim_warm_reset(struct ss_context *ctx);
+
+/**
+ * @brief Cold reset of the UICC.
+ *
+ * Frees @p ctx, drops every RAM cache and creates a fresh context which
+ * reloads its state from storage.
+ *
+ * @param ctx  Soft SIM context, may be NULL.
+ *
+ * @return The new context, NULL on allocation failure. @p ctx itself,
+ *         not reset, when the calling thread cannot be bound to its
+ *         instance.
+ */
+struct ss_context *softsim_cold_reset(struct ss_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_TRANSACT_H_ */
@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Flash wear statistics of the soft SIM storage
+ *
+ * Counters cover the whole powered life of the device: they are persisted
+ * in a small NVS record and restored at boot.
+ */
+
+#ifndef SOFTSIM_WEAR_H_
+#define SOFTSIM_WEAR_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Files with the most flash bytes written */
+struct softsim_wear_file {
+    uint16_t nvs_id;
+    uint32_t writes;
+    uint32_t bytes;            /* Data and allocation entries */
+};
+
+struct softsim_wear_stats {
+    uint32_t uptime_s;         /* Powered time covered by the counters */
+    uint64_t bytes;            /* Flash bytes written by the storage */
+    uint32_t erases;           /* Sector erases, all sectors */
+    uint32_t erases_max;       /* Erases of the most worn sector */
+    uint32_t bytes_per_hour;
+    uint32_t erases_per_day;   /* Projected from bytes until sectors cycle */
+    uint32_t lifetime_days;    /* Remaining, UINT32_MAX if no wear yet */
+};
+
+/**
+ * @brief Get the counters and the lifetime projection.
+ *
+ * The lifetime is the time left before the most worn sector reaches
+ * CONFIG_SOFTSIM_WEAR_ENDURANCE erase cycles at the average erase rate
+ * so far. NVS rotates through the sectors, so they wear evenly.
+ */
+void softsim_wear_stats_get(struct softsim_wear_stats *stats);
+
+/**
+ * @brief Copy the files with the most bytes written, most first.
+ *
+ * @return Number of entries copied, at most @p max.
+ */
+int softsim_wear_files_get(struct softsim_wear_file *files, int max);
+
+/**
+ * @brief Persist the counters now instead of at the next period.
+ */
+int softsim_wear_save(void);
+
+/**
+ * @brief Reset the counters, persisted ones included.
+ */
+void softsim_wear_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTSIM_WEAR_H_ */
@@ -0,0 +1,239 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Mock nRF modem softsim layer
+ *
+ * Stands in for the softsim part of the nRF modem library on targets
+ * without a modem (native_sim). One request is in flight at a time, as
+ * with the real modem: the caller invokes the registered handler and
+ * blocks until the response comes back through nrf_modem_softsim_res()
+ * or nrf_modem_softsim_err(), possibly from the softsim work queue.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nrf_modem_softsim.h>
+#include <softsim/modem_mock.h>
+#include <softsim/transact.h>
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+static nrf_modem_softsim_req_handler_t req_handler;
+
+static K_MUTEX_DEFINE(mock_lock);
+static K_SEM_DEFINE(mock_done, 0, 1);
+
+/* Pending request, valid while mock_lock is held by the requester */
+static struct {
+    enum nrf_modem_softsim_cmd cmd;
+    uint16_t req_id;
+    uint8_t *rsp;
+    size_t rsp_size;
+    int result;
+} pending;
+
+static uint16_t next_req_id;
+
+int nrf_modem_softsim_req_handler_set(nrf_modem_softsim_req_handler_t handler)
+{
+    req_handler = handler;
+    return 0;
+}
+
+int nrf_modem_softsim_res(enum nrf_modem_softsim_cmd req, uint16_t req_id, void *data,
+                          uint16_t data_len)
+{
+    if (req != pending.cmd || req_id != pending.req_id) {
+        LOG_ERR("mock: unexpected response %d/%u", req, req_id);
+        return -EINVAL;
+    }
+
+    if (data_len > pending.rsp_size) {
+        pending.result = -ENOMEM;
+    } else {
+        if (data_len) {
+            memcpy(pending.rsp, data, data_len);
+        }
+        pending.result = data_len;
+    }
+
+    k_sem_give(&mock_done);
+
+    return 0;
+}
+
+int nrf_modem_softsim_err(enum nrf_modem_softsim_cmd req, uint16_t req_id)
+{
+    if (req != pending.cmd || req_id != pending.req_id) {
+        LOG_ERR("mock: unexpected error %d/%u", req, req_id);
+        return -EINVAL;
+    }
+
+    pending.result = -EIO;
+    k_sem_give(&mock_done);
+
+    return 0;
+}
+
+void nrf_modem_softsim_data_free(void *data)
+{
+    k_free(data);
+}
+
+int softsim_modem_mock_request(enum nrf_modem_softsim_cmd cmd, const uint8_t *data,
+                               uint16_t data_len, uint8_t *rsp, size_t rsp_size,
+                               k_timeout_t timeout)
+{
+    uint8_t *shm = NULL;
+    int ret;
+
+    if (!req_handler) {
+        return -ENODEV;
+    }
+
+    if (data_len) {
+        shm = k_malloc(data_len);
+        if (!shm) {
+            return -ENOMEM;
+        }
+        memcpy(shm, data, data_len);
+    }
+
+    k_mutex_lock(&mock_lock, K_FOREVER);
+
+    k_sem_reset(&mock_done);
+    pending.cmd = cmd;
+    pending.req_id = ++next_req_id;
+    pending.rsp = rsp;
+    pending.rsp_size = rsp_size;
+    pending.result = -EAGAIN;
+
+    req_handler(cmd, pending.req_id, shm, data_len);
+
+    ret = k_sem_take(&mock_done, timeout);
+    if (ret == 0) {
+        ret = pending.result;
+    }
+
+    /* Late responses must not match a new request */
+    pending.req_id = 0;
+
+    k_mutex_unlock(&mock_lock);
+
+    return ret;
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+#define MOCK_TIMEOUT K_SECONDS(5)
+
+static int mock_cmd(const struct shell *sh, enum nrf_modem_softsim_cmd cmd, const char *hex)
+{
+    uint8_t req[SOFTSIM_APDU_CMD_MAX];
+    uint8_t rsp[SOFTSIM_APDU_RSP_MAX];
+    size_t req_len = 0;
+    int ret;
+
+    if (hex) {
+        req_len = hex2bin(hex, strlen(hex), req, sizeof(req));
+        if (req_len == 0) {
+            shell_error(sh, "invalid hex APDU");
+            return -EINVAL;
+        }
+    }
+
+    ret = softsim_modem_mock_request(cmd, req, req_len, rsp, sizeof(rsp), MOCK_TIMEOUT);
+    if (ret < 0) {
+        shell_error(sh, "request failed: %d", ret);
+        return ret;
+    }
+
+    shell_hexdump(sh, rsp, ret);
+
+    return 0;
+}
+
+static int cmd_mock_init(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return mock_cmd(sh, NRF_MODEM_SOFTSIM_INIT, NULL);
+}
+
+static int cmd_mock_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return mock_cmd(sh, NRF_MODEM_SOFTSIM_RESET, NULL);
+}
+
+static int cmd_mock_deinit(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return mock_cmd(sh, NRF_MODEM_SOFTSIM_DEINIT, NULL);
+}
+
+static int cmd_mock_apdu(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    return mock_cmd(sh, NRF_MODEM_SOFTSIM_APDU, argv[1]);
+}
+
+/* Round-trip time through the modem glue, as seen from the modem side */
+static int cmd_mock_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    uint8_t req[SOFTSIM_APDU_CMD_MAX];
+    uint8_t rsp[SOFTSIM_APDU_RSP_MAX];
+    uint32_t count = (argc > 2) ? strtoul(argv[2], NULL, 0) : 100;
+    uint32_t min = UINT32_MAX, max = 0;
+    uint64_t total = 0;
+    size_t req_len;
+
+    req_len = hex2bin(argv[1], strlen(argv[1]), req, sizeof(req));
+    if (req_len == 0 || count == 0) {
+        shell_error(sh, "usage: bench <hex apdu> [count]");
+        return -EINVAL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t start = k_cycle_get_32();
+        int ret = softsim_modem_mock_request(NRF_MODEM_SOFTSIM_APDU, req, req_len, rsp,
+                                             sizeof(rsp), MOCK_TIMEOUT);
+        uint32_t cycles = k_cycle_get_32() - start;
+
+        if (ret < 0) {
+            shell_error(sh, "request %u failed: %d", i, ret);
+            return ret;
+        }
+        total += cycles;
+        min = MIN(min, cycles);
+        max = MAX(max, cycles);
+    }
+
+    shell_print(sh, "%u APDUs: min %u us, avg %u us, max %u us", count,
+                k_cyc_to_us_floor32(min), (uint32_t)k_cyc_to_us_floor64(total / count),
+                k_cyc_to_us_floor32(max));
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_modem,
+    SHELL_CMD(init, NULL, "Send INIT, print the ATR", cmd_mock_init),
+    SHELL_CMD(reset, NULL, "Send RESET, print the ATR", cmd_mock_reset),
+    SHELL_CMD(deinit, NULL, "Send DEINIT", cmd_mock_deinit),
+    SHELL_CMD_ARG(apdu, NULL, "Send <hex apdu>, print the response", cmd_mock_apdu, 2, 0),
+    SHELL_CMD_ARG(bench, NULL, "Send <hex apdu> [count] times, print latency",
+                  cmd_mock_bench, 2, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), modem, &sub_modem, "Mock modem requests", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
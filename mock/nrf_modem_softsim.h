@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Mock of the nrfxlib softsim interface
+ *
+ * Mirrors the declarations of nrfxlib's nrf_modem_softsim.h so that the
+ * built-in modem glue can be built and exercised on native_sim, where the
+ * nRF modem library is not available. Only used with
+ * CONFIG_SOFTSIM_MODEM_MOCK.
+ */
+
+#ifndef NRF_MODEM_SOFTSIM_H__
+#define NRF_MODEM_SOFTSIM_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum nrf_modem_softsim_cmd {
+    NRF_MODEM_SOFTSIM_INIT = 1,
+    NRF_MODEM_SOFTSIM_APDU = 2,
+    NRF_MODEM_SOFTSIM_DEINIT = 3,
+    NRF_MODEM_SOFTSIM_RESET = 4,
+};
+
+typedef void (*nrf_modem_softsim_req_handler_t)(enum nrf_modem_softsim_cmd req,
+                                                uint16_t req_id, void *data,
+                                                uint16_t data_len);
+
+int nrf_modem_softsim_req_handler_set(nrf_modem_softsim_req_handler_t handler);
+
+int nrf_modem_softsim_res(enum nrf_modem_softsim_cmd req, uint16_t req_id, void *data,
+                          uint16_t data_len);
+
+int nrf_modem_softsim_err(enum nrf_modem_softsim_cmd req, uint16_t req_id);
+
+void nrf_modem_softsim_data_free(void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_MODEM_SOFTSIM_H__ */
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: AGPL-3.0-only
+#
+# Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+#
+# Build a provisioned NVS partition image on the host
+#
+# The SIM files of a profile are laid out in the Zephyr NVS format under
+# the IDs src/fs_zephyr.c derives from their paths, so a device can be
+# provisioned by flashing the image next to the firmware instead of
+# writing every file at runtime.
+#
+# The image holds a freshly mounted file system: sectors are filled in
+# order, each one starting with a gc done entry, and at least one sector
+# stays erased as NVS requires.
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+from gen_static_files import parse as parse_static_files
+
+ERASED = 0xff
+ATE_SIZE = 8
+
+# Must match src/fs_zephyr.c
+NVS_ID_BASE = 0x1000
+NVS_ID_SPAN = 0x1000
+
+
+def crc8_ccitt(data, crc=0xff):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xff
+    return crc
+
+
+def ate(nvs_id, offset, length):
+    raw = struct.pack('<HHHB', nvs_id, offset, length, 0xff)
+    return raw + bytes([crc8_ccitt(raw)])
+
+
+def align(n, a):
+    return (n + a - 1) // a * a
+
+
+def path_id(id_base, path):
+    h = 5381
+    for c in path.encode():
+        h = (h * 33 + c) & 0xffffffff
+    return id_base + h % (NVS_ID_SPAN - 1)
+
+
+class NvsImage:
+    def __init__(self, sector_size, sector_count, wbs, data_crc):
+        self.sector_size = sector_size
+        self.sector_count = sector_count
+        self.wbs = wbs
+        self.ate_size = align(ATE_SIZE, wbs)
+        self.data_crc = data_crc
+        self.image = bytearray([ERASED]) * (sector_size * sector_count)
+        self.sector = -1
+        self._open_sector()
+
+    def _open_sector(self):
+        if self.sector >= 0:
+            # Close ATE: offset of the last ATE written in the sector
+            self._put(self.sector, self.sector_size - self.ate_size,
+                      ate(0xffff, self.ate_wra + self.ate_size, 0))
+        self.sector += 1
+        # NVS keeps one erased sector for garbage collection
+        if self.sector >= self.sector_count - 1:
+            sys.exit('image does not fit the partition')
+        self.data_wra = 0
+        self.ate_wra = self.sector_size - 2 * self.ate_size
+        self._write_ate(0xffff, 0)
+
+    def _put(self, sector, offset, data):
+        base = sector * self.sector_size + offset
+        self.image[base:base + len(data)] = data
+
+    def _write_ate(self, nvs_id, length):
+        self._put(self.sector, self.ate_wra, ate(nvs_id, self.data_wra, length))
+        self.ate_wra -= self.ate_size
+
+    def write(self, nvs_id, data):
+        if self.data_crc:
+            data = data + struct.pack('<I', zlib.crc32(data))
+        size = align(len(data), self.wbs)
+        # Room for the data, its ATE and the closing ATE
+        if size > self.sector_size - 4 * self.ate_size:
+            sys.exit(f'record 0x{nvs_id:04x} larger than a sector')
+        if self.ate_wra < self.data_wra + size + self.ate_size:
+            self._open_sector()
+        self._put(self.sector, self.data_wra, data)
+        self._write_ate(nvs_id, len(data))
+        self.data_wra += size
+
+    def used(self):
+        return self.sector * self.sector_size + self.data_wra + \
+            (self.sector_size - self.ate_wra - self.ate_size)
+
+
+def bcd_imsi(imsi):
+    if not imsi.isdigit() or not 6 <= len(imsi) <= 15:
+        sys.exit(f'invalid IMSI {imsi}')
+    # TS 31.102 EF IMSI: length, then digits with the parity nibble first
+    digits = [9 if len(imsi) % 2 else 1] + [int(d) for d in imsi]
+    if len(digits) % 2:
+        digits.append(0xf)
+    data = bytes(digits[i] | digits[i + 1] << 4 for i in range(0, len(digits), 2))
+    return bytes([len(data)]) + data.ljust(8, b'\xff')
+
+
+def key(value, what):
+    try:
+        data = bytes.fromhex(value)
+    except ValueError:
+        data = b''
+    if len(data) != 16:
+        sys.exit(f'{what} must be 32 hex digits')
+    return data
+
+
+def patch(files, name, offset, data):
+    content = bytearray(files.get(name, b''))
+    if len(content) < offset + len(data):
+        content += bytes([ERASED]) * (offset + len(data) - len(content))
+    content[offset:offset + len(data)] = data
+    files[name] = bytes(content)
+
+
+def load_dir(root):
+    files = {}
+    for dirpath, _, names in os.walk(root):
+        for n in names:
+            full = os.path.join(dirpath, n)
+            with open(full, 'rb') as f:
+                files[os.path.relpath(full, root).replace(os.sep, '/')] = f.read()
+    return files
+
+
+def write_ihex(path, data, address):
+    out = []
+
+    def record(kind, addr, payload):
+        raw = bytes([len(payload), addr >> 8 & 0xff, addr & 0xff, kind]) + payload
+        out.append(':' + (raw + bytes([-sum(raw) & 0xff])).hex().upper())
+
+    for i in range(0, len(data), 16):
+        addr = address + i
+        if i == 0 or addr & 0xffff == 0:
+            record(4, 0, struct.pack('>H', addr >> 16))
+        record(0, addr & 0xffff, bytes(data[i:i + 16]))
+    record(1, 0, b'')
+
+    with open(path, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Build a provisioned soft SIM NVS partition image')
+    src = parser.add_argument_group('profile')
+    src.add_argument('--static', help='ss_static_files_hex.c to start from')
+    src.add_argument('--dir', help='directory tree of files, e.g. DIR/3f00/7fff/6f07')
+    src.add_argument('--set', action='append', default=[], metavar='PATH=HEX',
+                     help='set a file content, e.g. 3f00/2fe2=98...')
+    src.add_argument('--imsi', help='IMSI written to EF IMSI')
+    src.add_argument('--imsi-path', default='3f00/7fff/6f07')
+    src.add_argument('--ki', help='Ki, 32 hex digits')
+    src.add_argument('--opc', help='OPc, 32 hex digits')
+    src.add_argument('--auth-path', default='3f00/a001',
+                     help='file holding Ki and OPc')
+    src.add_argument('--ki-offset', type=int, default=0)
+    src.add_argument('--opc-offset', type=int, default=16)
+
+    lay = parser.add_argument_group('layout, must match the firmware')
+    lay.add_argument('--storage-path', default='/softsim',
+                     help='CONFIG_SOFTSIM_STORAGE_PATH')
+    lay.add_argument('--instance', type=int, default=0)
+    lay.add_argument('--profile', type=int, default=0)
+    lay.add_argument('--profiles', type=int, default=1, help='CONFIG_SOFTSIM_PROFILES')
+    lay.add_argument('--sector-size', type=int, default=4096)
+    lay.add_argument('--sector-count', type=int, default=8)
+    lay.add_argument('--write-block-size', type=int, default=4)
+    lay.add_argument('--data-crc', action='store_true', help='CONFIG_NVS_DATA_CRC')
+
+    parser.add_argument('--offset', type=lambda v: int(v, 0), default=0,
+                        help='partition address, for Intel HEX output')
+    parser.add_argument('-o', '--output', required=True, help='.bin or .hex image')
+    args = parser.parse_args()
+
+    files = {}
+    if args.static:
+        with open(args.static) as f:
+            files.update(parse_static_files(f.read()))
+    if args.dir:
+        files.update(load_dir(args.dir))
+    for s in args.set:
+        name, _, value = s.partition('=')
+        files[name.strip('/')] = bytes.fromhex(value)
+    if args.imsi:
+        files[args.imsi_path] = bcd_imsi(args.imsi)
+    if args.ki:
+        patch(files, args.auth_path, args.ki_offset, key(args.ki, 'Ki'))
+    if args.opc:
+        patch(files, args.auth_path, args.opc_offset, key(args.opc, 'OPc'))
+    if not files:
+        sys.exit('no file to provision')
+
+    if not 0 <= args.profile < args.profiles:
+        sys.exit('profile out of range')
+    id_base = NVS_ID_BASE + (args.instance * args.profiles + args.profile) * NVS_ID_SPAN
+    if id_base + NVS_ID_SPAN > 0x10000:
+        sys.exit('instance and profile out of the NVS ID space')
+
+    ids = {}
+    for name in sorted(files):
+        nvs_id = path_id(id_base, f'{args.storage_path}/{name}')
+        if nvs_id in ids:
+            sys.exit(f'{name} and {ids[nvs_id]} map to the same NVS ID 0x{nvs_id:04x}')
+        ids[nvs_id] = name
+
+    img = NvsImage(args.sector_size, args.sector_count, args.write_block_size,
+                   args.data_crc)
+    for nvs_id, name in sorted(ids.items()):
+        img.write(nvs_id, files[name])
+
+    if args.output.endswith('.hex'):
+        write_ihex(args.output, img.image, args.offset)
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(img.image)
+
+    print(f'{len(files)} files, {img.used()}/{len(img.image)} bytes used')
+
+
+if __name__ == '__main__':
+    main()
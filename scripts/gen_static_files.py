@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: AGPL-3.0-only
+#
+# Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+#
+# Pack the static SIM files of onomondo-uicc into a binary C array
+#
+# utils/files-c-array/ss_static_files_hex.c stores each file as a path
+# and its content in hex text. This turns them into one const blob plus
+# an index sorted by path, so the firmware reads the files in place
+# from flash instead of decoding hex.
+
+import argparse
+import re
+import sys
+import zlib
+
+# { "path", "hex" "hex" ... }, designated initializers allowed
+ENTRY_RE = re.compile(
+    r'\{\s*(?:\.\w+\s*=\s*)?"([^"]+)"\s*,\s*(?:\.\w+\s*=\s*)?((?:"[0-9A-Fa-f\s]*"\s*)+)')
+LITERAL_RE = re.compile(r'"([^"]*)"')
+
+
+def parse(text):
+    files = {}
+
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+    text = re.sub(r'//[^\n]*', '', text)
+
+    for m in ENTRY_RE.finditer(text):
+        name = m.group(1).strip('/')
+        data = ''.join(LITERAL_RE.findall(m.group(2)))
+        data = re.sub(r'\s', '', data)
+        if len(data) % 2:
+            sys.exit(f'{name}: odd number of hex digits')
+        if name in files:
+            sys.exit(f'{name}: duplicate file')
+        files[name] = bytes.fromhex(data)
+
+    if not files:
+        sys.exit('no static file found')
+
+    return files
+
+
+def emit(files, src):
+    out = []
+    blob = bytearray()
+    index = []
+
+    for name in sorted(files):
+        index.append((name, len(blob), len(files[name])))
+        blob += files[name]
+
+    out.append(f'/* Generated by gen_static_files.py from {src}, do not edit */\n')
+    out.append('#include <softsim/static_files.h>\n')
+    out.append(f'const uint8_t softsim_static_blob[{max(len(blob), 1)}] = {{')
+    for i in range(0, len(blob), 16):
+        out.append('    ' + ' '.join(f'0x{b:02x},' for b in blob[i:i + 16]))
+    out.append('};\n')
+    out.append('const struct softsim_static_file softsim_static_files[] = {')
+    for name, offset, size in index:
+        out.append(f'    {{ "{name}", {offset}, {size} }},')
+    out.append('};\n')
+    out.append(f'const size_t softsim_static_files_count = {len(index)};')
+
+    # Covers the paths too: a renamed file changes the hash
+    digest = zlib.crc32(blob)
+    for name, offset, size in index:
+        digest = zlib.crc32(f'{name}:{offset}:{size}'.encode(), digest)
+    out.append(f'const uint32_t softsim_static_files_hash = 0x{digest:08x};')
+
+    return '\n'.join(out) + '\n', len(blob)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Pack ss_static_files_hex.c into a binary C array')
+    parser.add_argument('input', help='ss_static_files_hex.c')
+    parser.add_argument('-o', '--output', required=True, help='generated C file')
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        files = parse(f.read())
+
+    code, size = emit(files, args.input.split('/')[-1])
+
+    with open(args.output, 'w') as f:
+        f.write(code)
+
+    print(f'{len(files)} static files, {size} bytes')
+
+
+if __name__ == '__main__':
+    main()
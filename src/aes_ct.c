@@ -0,0 +1,377 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Table-free constant-time AES-128 encryption
+ *
+ * Replaces crypto/aes-internal-enc.c. The state is held bitsliced: eight
+ * 32-bit words, word i carrying bit i of each of the 16 state bytes in
+ * its low 16 bits (bit 4c + r for row r, column c). SubBytes is the
+ * Boyar-Peralta S-box circuit evaluated on all bytes at once, ShiftRows
+ * and MixColumns are rotations and XORs of those words. There are no
+ * secret-dependent memory accesses or branches, and no 4 KiB lookup
+ * tables to pull through the flash cache.
+ *
+ * Decryption is left to the library (aes-internal-dec.c): MILENAGE only
+ * encrypts. AES-192 and AES-256 keys, which OTA keysets may use, are
+ * handed to the library table code (aes-internal-enc.c, built with its
+ * entry points renamed to aes_table_*).
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#include "softsim_internal.h"
+
+#define AES128_KEY_LEN 16
+#define AES128_ROUNDS  10
+
+/* crypto/aes-internal-enc.c of the UICC library, renamed in CMakeLists.txt */
+void *aes_table_encrypt_init(const uint8_t *key, size_t len);
+int aes_table_encrypt(void *ctx, const uint8_t *plain, uint8_t *crypt);
+void aes_table_encrypt_deinit(void *ctx);
+
+struct aes_ct_ctx {
+    void *table;                        /* Other key sizes: library context */
+    uint32_t rk[AES128_ROUNDS + 1][8];  /* Bitsliced round keys */
+};
+
+static void ct_wipe(void *buf, size_t len)
+{
+    volatile uint8_t *p = buf;
+
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+static void sbox_bitsliced(uint32_t *q)
+{
+    uint32_t u0 = q[7], u1 = q[6], u2 = q[5], u3 = q[4];
+    uint32_t u4 = q[3], u5 = q[2], u6 = q[1], u7 = q[0];
+    uint32_t t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14;
+    uint32_t t15, t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27;
+    uint32_t m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14;
+    uint32_t m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26;
+    uint32_t m27, m28, m29, m30, m31, m32, m33, m34, m35, m36, m37, m38;
+    uint32_t m39, m40, m41, m42, m43, m44, m45, m46, m47, m48, m49, m50;
+    uint32_t m51, m52, m53, m54, m55, m56, m57, m58, m59, m60, m61, m62, m63;
+    uint32_t l0, l1, l2, l3, l4, l5, l6, l7, l8, l9, l10, l11, l12, l13;
+    uint32_t l14, l15, l16, l17, l18, l19, l20, l21, l22, l23, l24, l25;
+    uint32_t l26, l27, l28, l29;
+
+    /* Top linear transform */
+    t1 = u0 ^ u3;
+    t2 = u0 ^ u5;
+    t3 = u0 ^ u6;
+    t4 = u3 ^ u5;
+    t5 = u4 ^ u6;
+    t6 = t1 ^ t5;
+    t7 = u1 ^ u2;
+    t8 = u7 ^ t6;
+    t9 = u7 ^ t7;
+    t10 = t6 ^ t7;
+    t11 = u1 ^ u5;
+    t12 = u2 ^ u5;
+    t13 = t3 ^ t4;
+    t14 = t6 ^ t11;
+    t15 = t5 ^ t11;
+    t16 = t5 ^ t12;
+    t17 = t9 ^ t16;
+    t18 = u3 ^ u7;
+    t19 = t7 ^ t18;
+    t20 = t1 ^ t19;
+    t21 = u6 ^ u7;
+    t22 = t7 ^ t21;
+    t23 = t2 ^ t22;
+    t24 = t2 ^ t10;
+    t25 = t20 ^ t17;
+    t26 = t3 ^ t16;
+    t27 = t1 ^ t12;
+
+    /* Inversion in GF(2^8) */
+    m1 = t13 & t6;
+    m2 = t23 & t8;
+    m3 = t14 ^ m1;
+    m4 = t19 & u7;
+    m5 = m4 ^ m1;
+    m6 = t3 & t16;
+    m7 = t22 & t9;
+    m8 = t26 ^ m6;
+    m9 = t20 & t17;
+    m10 = m9 ^ m6;
+    m11 = t1 & t15;
+    m12 = t4 & t27;
+    m13 = m12 ^ m11;
+    m14 = t2 & t10;
+    m15 = m14 ^ m11;
+    m16 = m3 ^ m2;
+    m17 = m5 ^ t24;
+    m18 = m8 ^ m7;
+    m19 = m10 ^ m15;
+    m20 = m16 ^ m13;
+    m21 = m17 ^ m15;
+    m22 = m18 ^ m13;
+    m23 = m19 ^ t25;
+    m24 = m22 ^ m23;
+    m25 = m22 & m20;
+    m26 = m21 ^ m25;
+    m27 = m20 ^ m21;
+    m28 = m23 ^ m25;
+    m29 = m28 & m27;
+    m30 = m26 & m24;
+    m31 = m20 & m23;
+    m32 = m27 & m31;
+    m33 = m27 ^ m25;
+    m34 = m21 & m22;
+    m35 = m24 & m34;
+    m36 = m24 ^ m25;
+    m37 = m21 ^ m29;
+    m38 = m32 ^ m33;
+    m39 = m23 ^ m30;
+    m40 = m35 ^ m36;
+    m41 = m38 ^ m40;
+    m42 = m37 ^ m39;
+    m43 = m37 ^ m38;
+    m44 = m39 ^ m40;
+    m45 = m42 ^ m41;
+    m46 = m44 & t6;
+    m47 = m40 & t8;
+    m48 = m39 & u7;
+    m49 = m43 & t16;
+    m50 = m38 & t9;
+    m51 = m37 & t17;
+    m52 = m42 & t15;
+    m53 = m45 & t27;
+    m54 = m41 & t10;
+    m55 = m44 & t13;
+    m56 = m40 & t23;
+    m57 = m39 & t19;
+    m58 = m43 & t3;
+    m59 = m38 & t22;
+    m60 = m37 & t20;
+    m61 = m42 & t1;
+    m62 = m45 & t4;
+    m63 = m41 & t2;
+
+    /* Bottom linear transform, affine constant folded in */
+    l0 = m61 ^ m62;
+    l1 = m50 ^ m56;
+    l2 = m46 ^ m48;
+    l3 = m47 ^ m55;
+    l4 = m54 ^ m58;
+    l5 = m49 ^ m61;
+    l6 = m62 ^ l5;
+    l7 = m46 ^ l3;
+    l8 = m51 ^ m59;
+    l9 = m52 ^ m53;
+    l10 = m53 ^ l4;
+    l11 = m60 ^ l2;
+    l12 = m48 ^ m51;
+    l13 = m50 ^ l0;
+    l14 = m52 ^ m61;
+    l15 = m55 ^ l1;
+    l16 = m56 ^ l0;
+    l17 = m57 ^ l1;
+    l18 = m58 ^ l8;
+    l19 = m63 ^ l4;
+    l20 = l0 ^ l1;
+    l21 = l1 ^ l7;
+    l22 = l3 ^ l12;
+    l23 = l18 ^ l2;
+    l24 = l15 ^ l9;
+    l25 = l6 ^ l10;
+    l26 = l7 ^ l9;
+    l27 = l8 ^ l10;
+    l28 = l11 ^ l14;
+    l29 = l11 ^ l17;
+
+    q[7] = l6 ^ l24;
+    q[6] = ~(l16 ^ l26);
+    q[5] = ~(l19 ^ l28);
+    q[4] = l6 ^ l21;
+    q[3] = l20 ^ l22;
+    q[2] = l25 ^ l29;
+    q[1] = ~(l13 ^ l27);
+    q[0] = ~(l6 ^ l23);
+}
+
+/* Spread n bytes over the low n bits of the eight words */
+static void bitslice(uint32_t *q, const uint8_t *in, size_t n)
+{
+    for (int i = 0; i < 8; i++) {
+        uint32_t w = 0;
+
+        for (size_t j = 0; j < n; j++) {
+            w |= (uint32_t)((in[j] >> i) & 1) << j;
+        }
+        q[i] = w;
+    }
+}
+
+static void unbitslice(uint8_t *out, const uint32_t *q, size_t n)
+{
+    for (size_t j = 0; j < n; j++) {
+        uint8_t b = 0;
+
+        for (int i = 0; i < 8; i++) {
+            b |= ((q[i] >> j) & 1) << i;
+        }
+        out[j] = b;
+    }
+}
+
+/* Row r rotated left by r columns: bit 4c + r takes bit 4(c + r) + r */
+static void shift_rows(uint32_t *q)
+{
+    for (int i = 0; i < 8; i++) {
+        uint32_t x = q[i];
+
+        q[i] = (x & 0x1111) |
+               (((x & 0x2222) >> 4) | ((x & 0x0002) << 12)) |
+               (((x & 0x4444) >> 8) | ((x & 0x0044) << 8)) |
+               (((x & 0x8888) >> 12) | ((x & 0x0888) << 4));
+    }
+}
+
+/* Within each column, row r takes the byte of row r + n */
+static inline uint32_t rot_rows1(uint32_t x)
+{
+    return ((x >> 1) & 0x7777) | ((x << 3) & 0x8888);
+}
+
+static inline uint32_t rot_rows2(uint32_t x)
+{
+    return ((x >> 2) & 0x3333) | ((x << 2) & 0xcccc);
+}
+
+static void mix_columns(uint32_t *q)
+{
+    uint32_t a1[8], t[8];
+
+    /* b = 2 (a ^ a1) ^ a1 ^ a2 ^ a3 */
+    for (int i = 0; i < 8; i++) {
+        uint32_t r1 = rot_rows1(q[i]);
+
+        a1[i] = r1 ^ rot_rows2(q[i]) ^ rot_rows2(r1);
+        t[i] = q[i] ^ r1;
+    }
+
+    /* Multiplication by x modulo x^8 + x^4 + x^3 + x + 1 */
+    q[0] = t[7] ^ a1[0];
+    q[1] = t[0] ^ t[7] ^ a1[1];
+    q[2] = t[1] ^ a1[2];
+    q[3] = t[2] ^ t[7] ^ a1[3];
+    q[4] = t[3] ^ t[7] ^ a1[4];
+    q[5] = t[4] ^ a1[5];
+    q[6] = t[5] ^ a1[6];
+    q[7] = t[6] ^ a1[7];
+}
+
+static void sub_word(uint8_t *w)
+{
+    uint32_t q[8];
+
+    bitslice(q, w, 4);
+    sbox_bitsliced(q);
+    unbitslice(w, q, 4);
+}
+
+static void key_expand(struct aes_ct_ctx *ctx, const uint8_t *key)
+{
+    uint8_t rk[AES128_KEY_LEN];
+    uint8_t rcon = 0x01;
+
+    memcpy(rk, key, sizeof(rk));
+    bitslice(ctx->rk[0], rk, AES128_KEY_LEN);
+
+    for (int r = 1; r <= AES128_ROUNDS; r++) {
+        uint8_t w[4] = { rk[13], rk[14], rk[15], rk[12] };
+
+        sub_word(w);
+        w[0] ^= rcon;
+        rcon = (rcon << 1) ^ ((rcon >> 7) * 0x1b);
+
+        for (int i = 0; i < AES128_KEY_LEN; i++) {
+            rk[i] ^= (i < 4) ? w[i] : rk[i - 4];
+        }
+        bitslice(ctx->rk[r], rk, AES128_KEY_LEN);
+    }
+
+    ct_wipe(rk, sizeof(rk));
+}
+
+static inline void add_round_key(uint32_t *q, const uint32_t *rk)
+{
+    for (int i = 0; i < 8; i++) {
+        q[i] ^= rk[i];
+    }
+}
+
+void *aes_encrypt_init(const uint8_t *key, size_t len)
+{
+    struct aes_ct_ctx *ctx;
+
+    ctx = softsim_malloc_persist(sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+
+    if (len == AES128_KEY_LEN) {
+        ctx->table = NULL;
+        key_expand(ctx, key);
+        return ctx;
+    }
+
+    ctx->table = aes_table_encrypt_init(key, len);
+    if (!ctx->table) {
+        softsim_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+int aes_encrypt(void *ctx, const uint8_t *plain, uint8_t *crypt)
+{
+    struct aes_ct_ctx *c = ctx;
+    uint32_t q[8];
+
+    if (c->table) {
+        return aes_table_encrypt(c->table, plain, crypt);
+    }
+
+    bitslice(q, plain, 16);
+    add_round_key(q, c->rk[0]);
+
+    for (int r = 1; r < AES128_ROUNDS; r++) {
+        sbox_bitsliced(q);
+        shift_rows(q);
+        mix_columns(q);
+        add_round_key(q, c->rk[r]);
+    }
+
+    sbox_bitsliced(q);
+    shift_rows(q);
+    add_round_key(q, c->rk[AES128_ROUNDS]);
+
+    unbitslice(crypt, q, 16);
+
+    return 0;
+}
+
+void aes_encrypt_deinit(void *ctx)
+{
+    struct aes_ct_ctx *c = ctx;
+
+    if (!c) {
+        return;
+    }
+
+    if (c->table) {
+        aes_table_encrypt_deinit(c->table);
+    }
+    ct_wipe(c, sizeof(*c));
+    softsim_free(c);
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * AES-128 single block encryption with a cached key schedule
+ *
+ * Replaces crypto/aes-encblock.c. MILENAGE encrypts every block with
+ * aes_128_encrypt_block(Ki, ...), which used to expand Ki for each of
+ * the blocks of f1-f5. The expanded key, as returned by the selected AES
+ * backend, is now kept from one call to the next and from one
+ * AUTHENTICATE to the next.
+ *
+ * The key passed in is compared with the cached copy on every call, so
+ * an update of the key file takes effect on the next block; the old
+ * schedule is then wiped. Everything is wiped when a context is freed
+ * and when the active profile changes.
+ *
+ * The key copies live in their own memory partition with
+ * CONFIG_USERSPACE: it belongs to no memory domain, so the MPU denies
+ * every user thread access to it. The schedules are taken from the soft
+ * SIM heap, never from the per-APDU arena, whatever the AES backend.
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#ifdef CONFIG_USERSPACE
+#include <zephyr/app_memory/app_memdomain.h>
+#endif
+
+#include "softsim_internal.h"
+
+#ifndef CONFIG_SOFTSIM_INSTANCES
+#define CONFIG_SOFTSIM_INSTANCES 1
+#endif
+
+#define AES128_KEY_LEN 16
+
+/* crypto/aes.h of the UICC library */
+void *aes_encrypt_init(const uint8_t *key, size_t len);
+int aes_encrypt(void *ctx, const uint8_t *plain, uint8_t *crypt);
+void aes_encrypt_deinit(void *ctx);
+
+/* One Ki per soft SIM instance */
+struct aes_key_slot {
+    void *ctx;                 /* Expanded key, NULL = free */
+    uint32_t last_use;
+    uint8_t key[AES128_KEY_LEN];
+};
+
+#ifdef CONFIG_USERSPACE
+K_APPMEM_PARTITION_DEFINE(softsim_key_part);
+#define KEY_SLOTS_SECTION K_APP_BMEM(softsim_key_part)
+#else
+#define KEY_SLOTS_SECTION Z_GENERIC_SECTION(.bss.softsim_keys)
+#endif
+
+static KEY_SLOTS_SECTION struct aes_key_slot slots[CONFIG_SOFTSIM_INSTANCES];
+static uint32_t key_tick;
+static K_MUTEX_DEFINE(key_lock);
+
+static void key_wipe(void *buf, size_t len)
+{
+    volatile uint8_t *p = buf;
+
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+/* Constant time: the comparison must not leak how much of Ki matched */
+static bool key_equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+
+    for (size_t i = 0; i < AES128_KEY_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void slot_drop(struct aes_key_slot *s)
+{
+    if (s->ctx) {
+        aes_encrypt_deinit(s->ctx);
+        s->ctx = NULL;
+    }
+    key_wipe(s->key, sizeof(s->key));
+    s->last_use = 0;
+}
+
+static struct aes_key_slot *slot_get(const uint8_t *key)
+{
+    struct aes_key_slot *lru = &slots[0];
+
+    for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+        if (slots[i].ctx && key_equal(slots[i].key, key)) {
+            return &slots[i];
+        }
+        if (slots[i].last_use < lru->last_use) {
+            lru = &slots[i];
+        }
+    }
+
+    slot_drop(lru);
+
+    /* The library table backend allocates through port_malloc() */
+    softsim_arena_suspend();
+    lru->ctx = aes_encrypt_init(key, AES128_KEY_LEN);
+    softsim_arena_resume();
+    if (!lru->ctx) {
+        return NULL;
+    }
+    memcpy(lru->key, key, AES128_KEY_LEN);
+
+    return lru;
+}
+
+int aes_128_encrypt_block(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    struct aes_key_slot *s;
+    int ret = -1;
+
+    k_mutex_lock(&key_lock, K_FOREVER);
+
+    s = slot_get(key);
+    if (s) {
+        s->last_use = ++key_tick;
+        ret = aes_encrypt(s->ctx, in, out);
+    }
+
+    k_mutex_unlock(&key_lock);
+
+    return ret;
+}
+
+void softsim_aes_key_cache_clear(void)
+{
+    k_mutex_lock(&key_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+        slot_drop(&slots[i]);
+    }
+
+    k_mutex_unlock(&key_lock);
+}
@@ -0,0 +1,360 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Allocation tracing for the UICC library
+ *
+ * port_malloc()/port_free() report every allocation with its call site
+ * (return address into the library) and size. Live allocations are
+ * tracked to measure their lifetime, and the results are summarised per
+ * call site and per APDU INS byte. An APDU in progress belongs to the
+ * thread processing it, so the APDUs of concurrent instances are counted
+ * apart. Resolve the call sites with
+ * addr2line against zephyr.elf. The module allocates through
+ * softsim_mem_alloc() and does not show up here.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_uicc, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/* INS entries, the last one collects allocations made outside APDUs */
+#define TRACE_INS_SLOTS 16
+
+#ifdef CONFIG_SOFTSIM_MULTI_INSTANCE
+#define TRACE_APDU_SLOTS CONFIG_SOFTSIM_INSTANCES
+#else
+#define TRACE_APDU_SLOTS 1
+#endif
+
+struct alloc_live {
+    void *ptr;                 /* NULL = free */
+    size_t size;
+    uint32_t start;            /* Cycle count at allocation */
+    uint32_t apdu;             /* APDU sequence number, 0 = outside */
+    uint8_t site;              /* Index in sites[] */
+};
+
+struct alloc_site {
+    void *addr;                /* Call site, NULL = free */
+    uint32_t count;
+    uint32_t live;
+    uint32_t survived;         /* Freed after their APDU completed */
+    uint64_t bytes;
+    uint32_t size_max;
+    uint64_t lifetime_cycles;  /* Total over freed allocations */
+    uint32_t lifetime_max;
+};
+
+/* APDU in progress on a thread */
+struct alloc_apdu {
+    k_tid_t tid;               /* NULL = free */
+    uint32_t seq;
+    uint8_t ins;
+    uint32_t allocs;
+    uint32_t bytes;
+};
+
+struct alloc_ins {
+    uint8_t ins;
+    bool used;
+    uint32_t apdus;
+    uint32_t allocs;
+    uint64_t bytes;
+    uint32_t apdu_bytes_max;   /* Most bytes allocated by one APDU */
+};
+
+static struct alloc_live live[CONFIG_SOFTSIM_ALLOC_TRACE_LIVE];
+static struct alloc_site sites[CONFIG_SOFTSIM_ALLOC_TRACE_SITES];
+static struct alloc_ins ins_stats[TRACE_INS_SLOTS];
+static uint32_t untracked;     /* Live table or site table full */
+
+static struct alloc_apdu apdus[TRACE_APDU_SLOTS];
+static uint32_t apdu_seq;
+
+static struct k_spinlock trace_lock;
+
+static struct alloc_site *site_get(void *addr)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(sites); i++) {
+        if (sites[i].addr == addr) {
+            return &sites[i];
+        }
+        if (!sites[i].addr) {
+            sites[i].addr = addr;
+            return &sites[i];
+        }
+    }
+    return NULL;
+}
+
+/* Called with trace_lock held */
+static struct alloc_apdu *apdu_find(k_tid_t tid)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(apdus); i++) {
+        if (apdus[i].tid == tid) {
+            return &apdus[i];
+        }
+    }
+    return NULL;
+}
+
+/* Called with trace_lock held */
+static bool apdu_in_progress(uint32_t seq)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(apdus); i++) {
+        if (apdus[i].tid && apdus[i].seq == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct alloc_ins *ins_get(uint8_t ins, bool in_apdu)
+{
+    struct alloc_ins *last = &ins_stats[ARRAY_SIZE(ins_stats) - 1];
+
+    if (!in_apdu) {
+        return last;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(ins_stats) - 1; i++) {
+        if (ins_stats[i].used && ins_stats[i].ins == ins) {
+            return &ins_stats[i];
+        }
+        if (!ins_stats[i].used) {
+            ins_stats[i].used = true;
+            ins_stats[i].ins = ins;
+            return &ins_stats[i];
+        }
+    }
+
+    /* Out of INS slots: account with the allocations outside APDUs */
+    return last;
+}
+
+void softsim_alloc_trace_alloc(void *ptr, size_t size, void *site)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+    struct alloc_apdu *a = apdu_find(k_current_get());
+    struct alloc_site *s = site_get(site);
+    struct alloc_live *l = NULL;
+
+    if (a) {
+        a->allocs++;
+        a->bytes += size;
+    } else {
+        struct alloc_ins *in = ins_get(0, false);
+
+        in->allocs++;
+        in->bytes += size;
+    }
+
+    if (s) {
+        s->count++;
+        s->bytes += size;
+        s->size_max = MAX(s->size_max, size);
+
+        for (size_t i = 0; i < ARRAY_SIZE(live); i++) {
+            if (!live[i].ptr) {
+                l = &live[i];
+                break;
+            }
+        }
+    }
+
+    if (l) {
+        l->ptr = ptr;
+        l->size = size;
+        l->start = k_cycle_get_32();
+        l->apdu = a ? a->seq : 0;
+        l->site = s - sites;
+        s->live++;
+    } else {
+        untracked++;
+    }
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+void softsim_alloc_trace_free(void *ptr)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    for (size_t i = 0; i < ARRAY_SIZE(live); i++) {
+        struct alloc_live *l = &live[i];
+
+        if (l->ptr == ptr) {
+            struct alloc_site *s = &sites[l->site];
+            uint32_t lifetime = k_cycle_get_32() - l->start;
+
+            s->live--;
+            s->lifetime_cycles += lifetime;
+            s->lifetime_max = MAX(s->lifetime_max, lifetime);
+            if (l->apdu && !apdu_in_progress(l->apdu)) {
+                s->survived++;
+            }
+            l->ptr = NULL;
+            break;
+        }
+    }
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+void softsim_alloc_trace_apdu_begin(uint8_t ins)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+    struct alloc_apdu *a = apdu_find(k_current_get());
+
+    /* Without a slot the APDU counts with the allocations outside APDUs */
+    if (!a) {
+        a = apdu_find(NULL);
+    }
+    if (a) {
+        if (++apdu_seq == 0) {
+            apdu_seq = 1;
+        }
+        a->tid = k_current_get();
+        a->seq = apdu_seq;
+        a->ins = ins;
+        a->allocs = 0;
+        a->bytes = 0;
+    }
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+void softsim_alloc_trace_apdu_end(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+    struct alloc_apdu *a = apdu_find(k_current_get());
+    struct alloc_ins *in;
+
+    if (a) {
+        in = ins_get(a->ins, true);
+        in->apdus++;
+        in->allocs += a->allocs;
+        in->bytes += a->bytes;
+        in->apdu_bytes_max = MAX(in->apdu_bytes_max, a->bytes);
+        a->tid = NULL;
+    }
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+static void alloc_trace_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    /* Keep tracking live allocations so that their frees still match */
+    for (size_t i = 0; i < ARRAY_SIZE(sites); i++) {
+        uint32_t n = sites[i].live;
+        void *addr = sites[i].addr;
+
+        memset(&sites[i], 0, sizeof(sites[i]));
+        if (n) {
+            sites[i].addr = addr;
+            sites[i].live = n;
+        }
+    }
+    memset(ins_stats, 0, sizeof(ins_stats));
+    untracked = 0;
+
+    k_spin_unlock(&trace_lock, key);
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_alloc_sites(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-10s %8s %8s %6s %8s %6s %10s %10s", "site", "count", "bytes", "max",
+                "survived", "live", "avg life", "max life");
+
+    for (size_t i = 0; i < ARRAY_SIZE(sites); i++) {
+        struct alloc_site s;
+        k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+        s = sites[i];
+        k_spin_unlock(&trace_lock, key);
+
+        if (!s.addr) {
+            break;
+        }
+        if (!s.count) {
+            continue;
+        }
+
+        shell_print(sh, "%-10p %8u %8llu %6u %8u %6u %8u us %8u us", s.addr, s.count,
+                    (unsigned long long)s.bytes, s.size_max, s.survived, s.live,
+                    (s.count > s.live) ?
+                    (uint32_t)k_cyc_to_us_floor64(s.lifetime_cycles / (s.count - s.live)) : 0,
+                    k_cyc_to_us_floor32(s.lifetime_max));
+    }
+
+    if (untracked) {
+        shell_print(sh, "%u allocations not tracked (tables full)", untracked);
+    }
+
+    return 0;
+}
+
+static int cmd_alloc_apdu(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-6s %8s %8s %10s %14s", "INS", "APDUs", "allocs", "bytes",
+                "max bytes/APDU");
+
+    for (size_t i = 0; i < ARRAY_SIZE(ins_stats); i++) {
+        struct alloc_ins in;
+        k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+        in = ins_stats[i];
+        k_spin_unlock(&trace_lock, key);
+
+        if (i == ARRAY_SIZE(ins_stats) - 1) {
+            if (in.allocs) {
+                shell_print(sh, "%-6s %8s %8u %10llu", "other", "-", in.allocs,
+                            (unsigned long long)in.bytes);
+            }
+        } else if (in.used) {
+            shell_print(sh, "%02x     %8u %8u %10llu %14u", in.ins, in.apdus, in.allocs,
+                        (unsigned long long)in.bytes, in.apdu_bytes_max);
+        }
+    }
+
+    return 0;
+}
+
+static int cmd_alloc_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    alloc_trace_reset();
+    shell_print(sh, "allocation trace reset");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_alloc,
+    SHELL_CMD(sites, NULL, "Allocations per call site", cmd_alloc_sites),
+    SHELL_CMD(apdu, NULL, "Allocations per APDU INS", cmd_alloc_apdu),
+    SHELL_CMD(reset, NULL, "Clear the allocation trace", cmd_alloc_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), alloc, &sub_alloc, "Allocation trace", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
@@ -0,0 +1,313 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * APDU capture in pcap format (GSMTAP SIM encapsulation)
+ *
+ * GSMTAP has no pcap link type of its own; it is normally sent over UDP
+ * to port 4729. Records are therefore written with LINKTYPE_RAW and a
+ * minimal IPv4/UDP header in front of the GSMTAP header, which is what
+ * Wireshark expects from a live GSMTAP capture.
+ *
+ * The capture buffer is linear: when it is full further APDUs are counted
+ * as dropped, keeping the beginning of the session (attach sequence) intact.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#ifdef CONFIG_FILE_SYSTEM
+#include <zephyr/fs/fs.h>
+#endif
+
+#include <softsim/apdu_pcap.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define PCAP_MAGIC          0xa1b2c3d4
+#define PCAP_VERSION_MAJOR  2
+#define PCAP_VERSION_MINOR  4
+#define PCAP_SNAPLEN        65535
+#define LINKTYPE_RAW        101
+
+#define GSMTAP_VERSION      0x02
+#define GSMTAP_TYPE_SIM     0x04
+#define GSMTAP_UDP_PORT     4729
+
+#define IPV4_HDR_LEN        20
+#define UDP_HDR_LEN         8
+#define GSMTAP_HDR_LEN      16
+#define PKT_HDR_LEN         (IPV4_HDR_LEN + UDP_HDR_LEN + GSMTAP_HDR_LEN)
+
+struct pcap_file_hdr {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;
+};
+
+struct pcap_rec_hdr {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+BUILD_ASSERT(CONFIG_SOFTSIM_APDU_PCAP_BUF_SIZE > sizeof(struct pcap_file_hdr),
+             "CONFIG_SOFTSIM_APDU_PCAP_BUF_SIZE too small");
+
+static uint8_t pcap_buf[CONFIG_SOFTSIM_APDU_PCAP_BUF_SIZE] __aligned(4);
+static size_t pcap_len;
+static uint32_t pcap_dropped;
+static struct k_spinlock pcap_lock;
+
+static void pcap_reset(void)
+{
+    const struct pcap_file_hdr hdr = {
+        .magic = PCAP_MAGIC,
+        .version_major = PCAP_VERSION_MAJOR,
+        .version_minor = PCAP_VERSION_MINOR,
+        .thiszone = 0,
+        .sigfigs = 0,
+        .snaplen = PCAP_SNAPLEN,
+        .network = LINKTYPE_RAW,
+    };
+
+    memcpy(pcap_buf, &hdr, sizeof(hdr));
+    pcap_len = sizeof(hdr);
+    pcap_dropped = 0;
+}
+
+static uint16_t ipv4_checksum(const uint8_t *hdr)
+{
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < IPV4_HDR_LEN; i += 2) {
+        sum += sys_get_be16(&hdr[i]);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return (uint16_t)~sum;
+}
+
+/* IPv4 127.0.0.1 -> 127.0.0.1, UDP -> 4729, GSMTAP SIM */
+static void build_pkt_hdr(uint8_t *p, size_t payload_len)
+{
+    uint16_t udp_len = UDP_HDR_LEN + GSMTAP_HDR_LEN + payload_len;
+    uint8_t *ip = p;
+    uint8_t *udp = p + IPV4_HDR_LEN;
+    uint8_t *gsmtap = udp + UDP_HDR_LEN;
+
+    memset(p, 0, PKT_HDR_LEN);
+
+    ip[0] = 0x45;                               /* IPv4, IHL = 5 */
+    sys_put_be16(IPV4_HDR_LEN + udp_len, &ip[2]);
+    ip[8] = 64;                                 /* TTL */
+    ip[9] = 17;                                 /* UDP */
+    sys_put_be32(0x7f000001, &ip[12]);
+    sys_put_be32(0x7f000001, &ip[16]);
+    sys_put_be16(ipv4_checksum(ip), &ip[10]);
+
+    sys_put_be16(GSMTAP_UDP_PORT, &udp[0]);
+    sys_put_be16(GSMTAP_UDP_PORT, &udp[2]);
+    sys_put_be16(udp_len, &udp[4]);
+    /* UDP checksum left at 0: optional over IPv4 */
+
+    gsmtap[0] = GSMTAP_VERSION;
+    gsmtap[1] = GSMTAP_HDR_LEN / 4;
+    gsmtap[2] = GSMTAP_TYPE_SIM;
+}
+
+void softsim_apdu_pcap_record(const struct softsim_apdu_info *info)
+{
+    struct pcap_rec_hdr rec;
+    size_t payload_len = info->cmd_len + info->rsp_len;
+    size_t rec_len = sizeof(rec) + PKT_HDR_LEN + payload_len;
+    uint64_t ts_us;
+    k_spinlock_key_t key;
+    uint8_t *p;
+
+    /* Timestamp the exchange at the start of the command */
+    ts_us = k_ticks_to_us_floor64(k_uptime_ticks()) - k_cyc_to_us_floor32(info->cycles);
+
+    rec.ts_sec = (uint32_t)(ts_us / USEC_PER_SEC);
+    rec.ts_usec = (uint32_t)(ts_us % USEC_PER_SEC);
+    rec.incl_len = PKT_HDR_LEN + payload_len;
+    rec.orig_len = rec.incl_len;
+
+    key = k_spin_lock(&pcap_lock);
+
+    if (pcap_len + rec_len > sizeof(pcap_buf)) {
+        pcap_dropped++;
+        k_spin_unlock(&pcap_lock, key);
+        return;
+    }
+
+    p = &pcap_buf[pcap_len];
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+    build_pkt_hdr(p, payload_len);
+    p += PKT_HDR_LEN;
+    memcpy(p, info->cmd, info->cmd_len);
+    p += info->cmd_len;
+    memcpy(p, info->rsp, info->rsp_len);
+    pcap_len += rec_len;
+
+    k_spin_unlock(&pcap_lock, key);
+}
+
+size_t softsim_apdu_pcap_get(const uint8_t **buf)
+{
+    *buf = pcap_buf;
+    return pcap_len;
+}
+
+uint32_t softsim_apdu_pcap_dropped(void)
+{
+    return pcap_dropped;
+}
+
+void softsim_apdu_pcap_clear(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&pcap_lock);
+
+    pcap_reset();
+
+    k_spin_unlock(&pcap_lock, key);
+}
+
+#ifdef CONFIG_FILE_SYSTEM
+int softsim_apdu_pcap_save(const char *path)
+{
+    struct fs_file_t file;
+    size_t len = pcap_len;
+    ssize_t written;
+    int err;
+
+    fs_file_t_init(&file);
+
+    err = fs_open(&file, path, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (err) {
+        LOG_ERR("pcap: cannot open %s: %d", path, err);
+        return err;
+    }
+
+    /* Records are only appended, the first len bytes are stable */
+    written = fs_write(&file, pcap_buf, len);
+    err = fs_close(&file);
+
+    if (written < 0) {
+        LOG_ERR("pcap: write to %s failed: %d", path, (int)written);
+        return (int)written;
+    }
+    if ((size_t)written != len) {
+        return -ENOSPC;
+    }
+
+    LOG_INF("pcap: saved %zu bytes to %s", len, path);
+
+    return err;
+}
+#else
+int softsim_apdu_pcap_save(const char *path)
+{
+    ARG_UNUSED(path);
+    return -ENOTSUP;
+}
+#endif /* CONFIG_FILE_SYSTEM */
+
+static int softsim_apdu_pcap_init(void)
+{
+    pcap_reset();
+    return 0;
+}
+
+SYS_INIT(softsim_apdu_pcap_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_pcap_info(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "capture: %zu/%zu bytes, %u dropped", pcap_len, sizeof(pcap_buf),
+                pcap_dropped);
+
+    return 0;
+}
+
+/* Plain hex, 32 bytes per line: convert back with "xxd -r -p" */
+static int cmd_pcap_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    static const char hex[] = "0123456789abcdef";
+    char line[32 * 2 + 1];
+    size_t len = pcap_len;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (size_t off = 0; off < len; off += 32) {
+        size_t n = MIN(len - off, 32);
+
+        for (size_t i = 0; i < n; i++) {
+            line[2 * i] = hex[pcap_buf[off + i] >> 4];
+            line[2 * i + 1] = hex[pcap_buf[off + i] & 0x0f];
+        }
+        line[2 * n] = '\0';
+        shell_print(sh, "%s", line);
+    }
+
+    return 0;
+}
+
+static int cmd_pcap_save(const struct shell *sh, size_t argc, char **argv)
+{
+    int err;
+
+    ARG_UNUSED(argc);
+
+    err = softsim_apdu_pcap_save(argv[1]);
+    if (err) {
+        shell_error(sh, "save failed: %d", err);
+        return err;
+    }
+
+    shell_print(sh, "saved %zu bytes to %s", pcap_len, argv[1]);
+
+    return 0;
+}
+
+static int cmd_pcap_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_apdu_pcap_clear();
+    shell_print(sh, "capture restarted");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_pcap,
+    SHELL_CMD(info, NULL, "Capture buffer usage", cmd_pcap_info),
+    SHELL_CMD(dump, NULL, "Print the pcap stream as hex (xxd -r -p)", cmd_pcap_dump),
+    SHELL_CMD_ARG(save, NULL, "Write the pcap stream to <path>", cmd_pcap_save, 2, 0),
+    SHELL_CMD(clear, NULL, "Restart the capture", cmd_pcap_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), pcap, &sub_pcap, "APDU capture (pcap, GSMTAP SIM)", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
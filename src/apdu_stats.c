@@ -0,0 +1,390 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * APDU latency histograms and per-INS profiling counters
+ *
+ * Latencies are taken with k_cycle_get_32() around ss_transact() and
+ * around every NVS call of the storage backend. Storage time spent by the
+ * thread processing an APDU, between softsim_apdu_stats_begin() and the
+ * record, is attributed to that APDU's INS class. Storage calls of other
+ * threads (provisioning, write-back flush, GC, ...) only count in the
+ * storage totals.
+ * Totals are also exported through the Zephyr stats subsystem.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/stats/stats.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include <softsim/apdu_stats.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/* Commands of ETSI TS 102 221 / 3GPP TS 31.102 worth telling apart */
+static const struct {
+    uint8_t ins;
+    const char *name;
+} ins_names[] = {
+    { 0xa4, "SELECT" },
+    { 0xf2, "STATUS" },
+    { 0xb0, "READ BINARY" },
+    { 0xd6, "UPDATE BINARY" },
+    { 0xb2, "READ RECORD" },
+    { 0xdc, "UPDATE RECORD" },
+    { 0xa2, "SEARCH RECORD" },
+    { 0x32, "INCREASE" },
+    { 0x20, "VERIFY PIN" },
+    { 0x24, "CHANGE PIN" },
+    { 0x26, "DISABLE PIN" },
+    { 0x28, "ENABLE PIN" },
+    { 0x2c, "UNBLOCK PIN" },
+    { 0x88, "AUTHENTICATE" },
+    { 0x70, "MANAGE CHANNEL" },
+    { 0xc0, "GET RESPONSE" },
+    { 0x10, "TERMINAL PROFILE" },
+    { 0x12, "FETCH" },
+    { 0x14, "TERMINAL RESPONSE" },
+    { 0xc2, "ENVELOPE" },
+    { 0xaa, "TERMINAL CAPABILITY" },
+    { 0x76, "SUSPEND UICC" },
+};
+
+#define INS_CLASSES (ARRAY_SIZE(ins_names) + 1)
+#define INS_OTHER   (INS_CLASSES - 1)
+
+static const char *const storage_op_names[SOFTSIM_STORAGE_OP_COUNT] = {
+    [SOFTSIM_STORAGE_READ] = "read",
+    [SOFTSIM_STORAGE_WRITE] = "write",
+    [SOFTSIM_STORAGE_DELETE] = "delete",
+};
+
+static struct softsim_apdu_stats_ins ins_stats[INS_CLASSES];
+static struct softsim_storage_stats storage_stats[SOFTSIM_STORAGE_OP_COUNT];
+
+#ifdef CONFIG_SOFTSIM_MULTI_INSTANCE
+#define APDU_SLOTS CONFIG_SOFTSIM_INSTANCES
+#else
+#define APDU_SLOTS 1
+#endif
+
+/* Storage time of the APDUs in progress, one per processing thread */
+struct apdu_slot {
+    k_tid_t tid;               /* NULL = free */
+    uint32_t storage_cycles;
+};
+
+static struct apdu_slot apdu_slots[APDU_SLOTS];
+
+static uint32_t budget_cycles;
+
+static struct k_spinlock stats_lock;
+
+STATS_SECT_START(softsim_apdu)
+STATS_SECT_ENTRY32(apdus)
+STATS_SECT_ENTRY32(over_budget)
+STATS_SECT_ENTRY32(storage_reads)
+STATS_SECT_ENTRY32(storage_writes)
+STATS_SECT_ENTRY32(storage_deletes)
+STATS_SECT_END;
+
+STATS_NAME_START(softsim_apdu)
+STATS_NAME(softsim_apdu, apdus)
+STATS_NAME(softsim_apdu, over_budget)
+STATS_NAME(softsim_apdu, storage_reads)
+STATS_NAME(softsim_apdu, storage_writes)
+STATS_NAME(softsim_apdu, storage_deletes)
+STATS_NAME_END(softsim_apdu);
+
+static STATS_SECT_DECL(softsim_apdu) softsim_apdu_stats;
+
+static size_t ins_class(uint8_t ins)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(ins_names); i++) {
+        if (ins_names[i].ins == ins) {
+            return i;
+        }
+    }
+    return INS_OTHER;
+}
+
+/* Called with stats_lock held */
+static struct apdu_slot *apdu_slot_find(k_tid_t tid)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(apdu_slots); i++) {
+        if (apdu_slots[i].tid == tid) {
+            return &apdu_slots[i];
+        }
+    }
+    return NULL;
+}
+
+void softsim_apdu_stats_begin(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    struct apdu_slot *slot = apdu_slot_find(k_current_get());
+
+    /* Without a slot the storage time of this APDU is not attributed */
+    if (!slot) {
+        slot = apdu_slot_find(NULL);
+    }
+    if (slot) {
+        slot->tid = k_current_get();
+        slot->storage_cycles = 0;
+    }
+
+    k_spin_unlock(&stats_lock, key);
+}
+
+static size_t hist_bucket(uint32_t cycles)
+{
+    uint32_t us = k_cyc_to_us_floor32(cycles) >> 6;
+    size_t b = 0;
+
+    while (us && b < SOFTSIM_APDU_STATS_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+
+    return b;
+}
+
+void softsim_apdu_stats_record(const struct softsim_apdu_info *info)
+{
+    struct softsim_apdu_stats_ins *s;
+    struct apdu_slot *slot;
+    k_spinlock_key_t key;
+    bool over;
+
+    s = &ins_stats[ins_class(softsim_apdu_ins(info->cmd, info->cmd_len))];
+    over = budget_cycles && info->cycles > budget_cycles;
+
+    key = k_spin_lock(&stats_lock);
+
+    s->count++;
+    s->cycles_total += info->cycles;
+    s->cycles_min = MIN(s->cycles_min, info->cycles);
+    s->cycles_max = MAX(s->cycles_max, info->cycles);
+    slot = apdu_slot_find(k_current_get());
+    if (slot) {
+        s->storage_cycles += slot->storage_cycles;
+        slot->tid = NULL;
+    }
+    s->hist[hist_bucket(info->cycles)]++;
+    if (over) {
+        s->over_budget++;
+    }
+
+    k_spin_unlock(&stats_lock, key);
+
+    STATS_INC(softsim_apdu_stats, apdus);
+    if (over) {
+        STATS_INC(softsim_apdu_stats, over_budget);
+        LOG_DBG("%s took %u us (budget %u us)", s->name, k_cyc_to_us_floor32(info->cycles),
+                CONFIG_SOFTSIM_APDU_STATS_BUDGET_US);
+    }
+}
+
+void softsim_apdu_stats_storage(enum softsim_storage_op op, uint32_t cycles)
+{
+    struct softsim_storage_stats *s = &storage_stats[op];
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    struct apdu_slot *slot = apdu_slot_find(k_current_get());
+
+    s->count++;
+    s->cycles_total += cycles;
+    s->cycles_max = MAX(s->cycles_max, cycles);
+    if (slot) {
+        slot->storage_cycles += cycles;
+    }
+
+    k_spin_unlock(&stats_lock, key);
+
+    switch (op) {
+    case SOFTSIM_STORAGE_READ:
+        STATS_INC(softsim_apdu_stats, storage_reads);
+        break;
+    case SOFTSIM_STORAGE_WRITE:
+        STATS_INC(softsim_apdu_stats, storage_writes);
+        break;
+    case SOFTSIM_STORAGE_DELETE:
+        STATS_INC(softsim_apdu_stats, storage_deletes);
+        break;
+    default:
+        break;
+    }
+}
+
+size_t softsim_apdu_stats_ins_count(void)
+{
+    return INS_CLASSES;
+}
+
+int softsim_apdu_stats_ins_get(size_t idx, struct softsim_apdu_stats_ins *out)
+{
+    k_spinlock_key_t key;
+
+    if (idx >= INS_CLASSES) {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&stats_lock);
+    *out = ins_stats[idx];
+    k_spin_unlock(&stats_lock, key);
+
+    return 0;
+}
+
+size_t softsim_storage_stats_count(void)
+{
+    return SOFTSIM_STORAGE_OP_COUNT;
+}
+
+int softsim_storage_stats_get(size_t idx, struct softsim_storage_stats *out)
+{
+    k_spinlock_key_t key;
+
+    if (idx >= SOFTSIM_STORAGE_OP_COUNT) {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&stats_lock);
+    *out = storage_stats[idx];
+    k_spin_unlock(&stats_lock, key);
+
+    return 0;
+}
+
+void softsim_apdu_stats_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+    for (size_t i = 0; i < INS_CLASSES; i++) {
+        struct softsim_apdu_stats_ins *s = &ins_stats[i];
+
+        memset(s, 0, sizeof(*s));
+        s->name = (i < INS_OTHER) ? ins_names[i].name : "OTHER";
+        s->ins = (i < INS_OTHER) ? ins_names[i].ins : 0;
+        s->cycles_min = UINT32_MAX;
+    }
+
+    for (size_t i = 0; i < SOFTSIM_STORAGE_OP_COUNT; i++) {
+        memset(&storage_stats[i], 0, sizeof(storage_stats[i]));
+        storage_stats[i].name = storage_op_names[i];
+    }
+
+    memset(apdu_slots, 0, sizeof(apdu_slots));
+
+    k_spin_unlock(&stats_lock, key);
+}
+
+static int softsim_apdu_stats_init(void)
+{
+    budget_cycles = (uint32_t)k_us_to_cyc_ceil64(CONFIG_SOFTSIM_APDU_STATS_BUDGET_US);
+
+    softsim_apdu_stats_reset();
+
+    return stats_init_and_reg(STATS_HDR(softsim_apdu_stats),
+                              STATS_SIZE_INIT_PARMS(softsim_apdu_stats, STATS_SIZE_32),
+                              STATS_NAME_INIT_PARMS(softsim_apdu), "softsim_apdu");
+}
+
+SYS_INIT(softsim_apdu_stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_stats_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct softsim_apdu_stats_ins s;
+    struct softsim_storage_stats st;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%-20s %8s %8s %8s %8s %8s %6s", "command", "count", "min us", "avg us",
+                "max us", "stor us", "over");
+    for (size_t i = 0; i < INS_CLASSES; i++) {
+        softsim_apdu_stats_ins_get(i, &s);
+        if (s.count == 0) {
+            continue;
+        }
+        shell_print(sh, "%-20s %8u %8u %8u %8u %8u %6u", s.name, s.count,
+                    k_cyc_to_us_floor32(s.cycles_min),
+                    (uint32_t)k_cyc_to_us_floor64(s.cycles_total / s.count),
+                    k_cyc_to_us_floor32(s.cycles_max),
+                    (uint32_t)k_cyc_to_us_floor64(s.storage_cycles / s.count), s.over_budget);
+    }
+
+    shell_print(sh, "");
+    shell_print(sh, "%-20s %8s %8s %8s", "storage", "count", "avg us", "max us");
+    for (size_t i = 0; i < SOFTSIM_STORAGE_OP_COUNT; i++) {
+        softsim_storage_stats_get(i, &st);
+        if (st.count == 0) {
+            continue;
+        }
+        shell_print(sh, "%-20s %8u %8u %8u", st.name, st.count,
+                    (uint32_t)k_cyc_to_us_floor64(st.cycles_total / st.count),
+                    k_cyc_to_us_floor32(st.cycles_max));
+    }
+
+    return 0;
+}
+
+static int cmd_stats_hist(const struct shell *sh, size_t argc, char **argv)
+{
+    struct softsim_apdu_stats_ins s;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (size_t i = 0; i < INS_CLASSES; i++) {
+        softsim_apdu_stats_ins_get(i, &s);
+        if (s.count == 0) {
+            continue;
+        }
+
+        shell_print(sh, "%s:", s.name);
+        for (size_t b = 0; b < SOFTSIM_APDU_STATS_BUCKETS; b++) {
+            if (s.hist[b] == 0) {
+                continue;
+            }
+            if (b == 0) {
+                shell_print(sh, "  %9s < %7u us: %u", "", 64, s.hist[b]);
+            } else if (b == SOFTSIM_APDU_STATS_BUCKETS - 1) {
+                shell_print(sh, "  %9s >= %6u us: %u", "", 32U << b, s.hist[b]);
+            } else {
+                shell_print(sh, "  %7u .. %7u us: %u", 32U << b, (64U << b) - 1, s.hist[b]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_apdu_stats_reset();
+    shell_print(sh, "APDU statistics cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_stats,
+    SHELL_CMD(show, NULL, "Per-command latency and storage time", cmd_stats_show),
+    SHELL_CMD(hist, NULL, "Per-command latency histograms", cmd_stats_hist),
+    SHELL_CMD(reset, NULL, "Clear all counters", cmd_stats_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), stats, &sub_stats, "APDU latency statistics", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
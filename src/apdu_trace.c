@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Binary APDU trace ring buffer
+ *
+ * Writers claim a slot with an atomic increment and publish the entry by
+ * storing its sequence number last, so several threads may record at once
+ * and readers can detect a slot being rewritten under them.
+ *
+ * The ring lives in .noinit: after a fault and warm reboot the previous
+ * APDUs are still there for the shell. With CONFIG_DEBUG_COREDUMP it is
+ * registered as a coredump memory region, so it is dumped whatever the
+ * coredump memory mode.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#ifdef CONFIG_DEBUG_COREDUMP
+#include <zephyr/debug/coredump.h>
+#endif
+
+#include <softsim/apdu_trace.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define TRACE_ENTRIES CONFIG_SOFTSIM_APDU_TRACE_ENTRIES
+#define TRACE_MASK    (TRACE_ENTRIES - 1)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(TRACE_ENTRIES),
+             "CONFIG_SOFTSIM_APDU_TRACE_ENTRIES must be a power of two");
+
+/* Layout kept stable so the ring can be decoded from a raw memory dump */
+struct softsim_apdu_trace_ring {
+    uint32_t magic;
+    uint16_t entry_size;
+    uint16_t entry_count;
+    atomic_t head;             /* Last sequence number handed out */
+    struct softsim_apdu_trace_entry entries[TRACE_ENTRIES];
+};
+
+__noinit struct softsim_apdu_trace_ring softsim_apdu_trace;
+
+#ifdef CONFIG_DEBUG_COREDUMP
+static struct coredump_mem_region_node trace_region = {
+    .start = (uintptr_t)&softsim_apdu_trace,
+    .size = sizeof(softsim_apdu_trace),
+};
+#endif
+
+void softsim_apdu_trace_record(const struct softsim_apdu_info *info)
+{
+    struct softsim_apdu_trace_entry *e;
+    uint32_t seq;
+
+    seq = (uint32_t)atomic_inc(&softsim_apdu_trace.head) + 1;
+    if (seq == 0) {
+        /* 0 marks an empty slot, skip it on wrap-around */
+        seq = (uint32_t)atomic_inc(&softsim_apdu_trace.head) + 1;
+    }
+
+    e = &softsim_apdu_trace.entries[seq & TRACE_MASK];
+
+    /* Invalidate the slot while it is being rewritten */
+    e->seq = 0;
+    compiler_barrier();
+
+    e->timestamp = k_uptime_get_32();
+    e->cycles = info->cycles;
+    memset(e->hdr, 0, sizeof(e->hdr));
+    memcpy(e->hdr, info->cmd, MIN(info->cmd_len, sizeof(e->hdr)));
+    e->lc = softsim_apdu_lc(info->cmd, info->cmd_len);
+    e->rsp_len = (info->rsp_len >= 2) ? info->rsp_len - 2 : 0;
+    e->sw = info->sw;
+    e->reserved = 0;
+
+    compiler_barrier();
+    e->seq = seq;
+}
+
+/* Copy the entry of a sequence number, false if empty or rewritten */
+static bool trace_entry_copy(uint32_t seq, struct softsim_apdu_trace_entry *out)
+{
+    const struct softsim_apdu_trace_entry *e = &softsim_apdu_trace.entries[seq & TRACE_MASK];
+
+    if (seq == 0 || e->seq != seq) {
+        return false;
+    }
+
+    *out = *e;
+    compiler_barrier();
+
+    /* Overwritten while copying: drop it */
+    return e->seq == seq;
+}
+
+size_t softsim_apdu_trace_get(struct softsim_apdu_trace_entry *out, size_t max)
+{
+    uint32_t head = (uint32_t)atomic_get(&softsim_apdu_trace.head);
+    uint32_t seq;
+    size_t n = 0;
+
+    if (max == 0) {
+        return 0;
+    }
+
+    seq = head - MIN((uint32_t)TRACE_ENTRIES - 1, (uint32_t)max - 1);
+
+    for (; n < max && (int32_t)(head - seq) >= 0; seq++) {
+        if (trace_entry_copy(seq, &out[n])) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+void softsim_apdu_trace_clear(void)
+{
+    for (size_t i = 0; i < TRACE_ENTRIES; i++) {
+        softsim_apdu_trace.entries[i].seq = 0;
+    }
+}
+
+static int softsim_apdu_trace_init(void)
+{
+    struct softsim_apdu_trace_ring *ring = &softsim_apdu_trace;
+
+    /* Keep the content of a previous boot if the layout matches */
+    if (ring->magic == SOFTSIM_APDU_TRACE_MAGIC &&
+        ring->entry_size == sizeof(struct softsim_apdu_trace_entry) &&
+        ring->entry_count == TRACE_ENTRIES) {
+        LOG_DBG("APDU trace retained, head=%lu", (unsigned long)atomic_get(&ring->head));
+    } else {
+        memset(ring, 0, sizeof(*ring));
+        ring->magic = SOFTSIM_APDU_TRACE_MAGIC;
+        ring->entry_size = sizeof(struct softsim_apdu_trace_entry);
+        ring->entry_count = TRACE_ENTRIES;
+    }
+
+#ifdef CONFIG_DEBUG_COREDUMP
+    coredump_register_memory_region(&trace_region);
+#endif
+
+    return 0;
+}
+
+SYS_INIT(softsim_apdu_trace_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_trace_show(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t head = (uint32_t)atomic_get(&softsim_apdu_trace.head);
+    struct softsim_apdu_trace_entry e;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%8s %10s  CLA INS P1 P2  Lc   Rsp  SW    us", "seq", "t(ms)");
+
+    /* One entry at a time, the ring can be large */
+    for (uint32_t seq = head - (TRACE_ENTRIES - 1); (int32_t)(head - seq) >= 0; seq++) {
+        if (!trace_entry_copy(seq, &e)) {
+            continue;
+        }
+        shell_print(sh, "%8u %10u  %02x  %02x  %02x %02x  %3u  %4u  %04x  %u",
+                    e.seq, e.timestamp, e.hdr[0], e.hdr[1], e.hdr[2], e.hdr[3],
+                    e.lc, e.rsp_len, e.sw, k_cyc_to_us_floor32(e.cycles));
+    }
+
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_apdu_trace_clear();
+    shell_print(sh, "APDU trace cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_trace,
+    SHELL_CMD(show, NULL, "Dump recorded APDUs, oldest first", cmd_trace_show),
+    SHELL_CMD(clear, NULL, "Drop recorded APDUs", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), trace, &sub_trace, "Binary APDU trace", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
@@ -0,0 +1,106 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Asynchronous APDU transaction service
+ *
+ * Each request takes a slot from a memory slab holding both the command
+ * and the response buffer, then is queued on the softsim work queue.
+ * The single queue thread keeps APDUs strictly ordered, which the UICC
+ * state machine requires, while the submitter is free to accept the next
+ * request as soon as the previous one is queued.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include <softsim/async.h>
+#include <softsim/transact.h>
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+struct softsim_async_req {
+    struct k_work work;
+    struct ss_context *ctx;
+    softsim_async_cb_t cb;
+    void *user_data;
+    size_t req_len;
+    uint8_t req[SOFTSIM_APDU_CMD_MAX];
+    uint8_t rsp[SOFTSIM_APDU_RSP_MAX];
+};
+
+K_MEM_SLAB_DEFINE_STATIC(softsim_async_slab,
+                         ROUND_UP(sizeof(struct softsim_async_req), sizeof(void *)),
+                         CONFIG_SOFTSIM_ASYNC_QUEUE_DEPTH, sizeof(void *));
+
+K_THREAD_STACK_DEFINE(softsim_async_stack, CONFIG_SOFTSIM_ASYNC_STACK_SIZE);
+
+static struct k_work_q softsim_async_wq;
+
+static void async_work_handler(struct k_work *work)
+{
+    struct softsim_async_req *r = CONTAINER_OF(work, struct softsim_async_req, work);
+    size_t req_len = r->req_len;
+    size_t rsp_len;
+
+    rsp_len = softsim_transact(r->ctx, r->rsp, sizeof(r->rsp), r->req, &req_len);
+
+    if (rsp_len < 2) {
+        LOG_ERR("async: no response for INS %02x", r->req[1]);
+        r->cb(-EIO, NULL, 0, r->user_data);
+    } else {
+        r->cb(0, r->rsp, rsp_len, r->user_data);
+    }
+
+    k_mem_slab_free(&softsim_async_slab, r);
+}
+
+int softsim_async_submit(struct ss_context *ctx, const uint8_t *req, size_t req_len,
+                         softsim_async_cb_t cb, void *user_data)
+{
+    struct softsim_async_req *r;
+
+    if (!ctx || !req || !cb || req_len < 4 || req_len > SOFTSIM_APDU_CMD_MAX) {
+        return -EINVAL;
+    }
+
+    if (k_mem_slab_alloc(&softsim_async_slab, (void **)&r, K_NO_WAIT)) {
+        LOG_WRN("async: queue full");
+        return -ENOBUFS;
+    }
+
+    k_work_init(&r->work, async_work_handler);
+    r->ctx = ctx;
+    r->cb = cb;
+    r->user_data = user_data;
+    r->req_len = req_len;
+    memcpy(r->req, req, req_len);
+
+    k_work_submit_to_queue(&softsim_async_wq, &r->work);
+
+    return 0;
+}
+
+struct k_work_q *softsim_async_queue(void)
+{
+    return &softsim_async_wq;
+}
+
+static int softsim_async_init(void)
+{
+    const struct k_work_queue_config cfg = {
+        .name = "softsim",
+    };
+
+    k_work_queue_init(&softsim_async_wq);
+    k_work_queue_start(&softsim_async_wq, softsim_async_stack,
+                       K_THREAD_STACK_SIZEOF(softsim_async_stack),
+                       CONFIG_SOFTSIM_ASYNC_PRIORITY, &cfg);
+
+    return 0;
+}
+
+SYS_INIT(softsim_async_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -0,0 +1,115 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * PSA Crypto backend for the UICC library AES primitives
+ *
+ * Replaces crypto/aes-internal*.c: the block cipher API used by
+ * MILENAGE (through aes_128_encrypt_block()) and by the OTA security
+ * (aes-wrap.c, utils_aes.c) is implemented on top of PSA Crypto, which
+ * is backed by mbedTLS on native_sim and by the CryptoCell or TF-M on
+ * nRF91 targets.
+ *
+ * Each init call imports the key as a volatile PSA key used for single
+ * ECB blocks; the chaining modes stay in the library.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <psa/crypto.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_uicc, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define AES_BLOCK_SIZE 16
+
+struct psa_aes_ctx {
+    psa_key_id_t key;
+};
+
+static void *psa_aes_init(const uint8_t *key, size_t len, psa_key_usage_t usage)
+{
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    struct psa_aes_ctx *ctx;
+    psa_status_t status;
+
+    status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa: init failed: %d", status);
+        return NULL;
+    }
+
+    ctx = softsim_malloc_persist(sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+
+    psa_set_key_usage_flags(&attr, usage);
+    psa_set_key_algorithm(&attr, PSA_ALG_ECB_NO_PADDING);
+    psa_set_key_type(&attr, PSA_KEY_TYPE_AES);
+    psa_set_key_bits(&attr, PSA_BYTES_TO_BITS(len));
+
+    status = psa_import_key(&attr, key, len, &ctx->key);
+    psa_reset_key_attributes(&attr);
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa: AES key import failed: %d", status);
+        softsim_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+static void psa_aes_deinit(void *ctx)
+{
+    struct psa_aes_ctx *c = ctx;
+
+    if (!c) {
+        return;
+    }
+
+    psa_destroy_key(c->key);
+    softsim_free(c);
+}
+
+void *aes_encrypt_init(const uint8_t *key, size_t len)
+{
+    return psa_aes_init(key, len, PSA_KEY_USAGE_ENCRYPT);
+}
+
+int aes_encrypt(void *ctx, const uint8_t *plain, uint8_t *crypt)
+{
+    struct psa_aes_ctx *c = ctx;
+    size_t out_len;
+
+    return psa_cipher_encrypt(c->key, PSA_ALG_ECB_NO_PADDING, plain, AES_BLOCK_SIZE, crypt,
+                              AES_BLOCK_SIZE, &out_len) == PSA_SUCCESS ? 0 : -1;
+}
+
+void aes_encrypt_deinit(void *ctx)
+{
+    psa_aes_deinit(ctx);
+}
+
+void *aes_decrypt_init(const uint8_t *key, size_t len)
+{
+    return psa_aes_init(key, len, PSA_KEY_USAGE_DECRYPT);
+}
+
+int aes_decrypt(void *ctx, const uint8_t *crypt, uint8_t *plain)
+{
+    struct psa_aes_ctx *c = ctx;
+    size_t out_len;
+
+    return psa_cipher_decrypt(c->key, PSA_ALG_ECB_NO_PADDING, crypt, AES_BLOCK_SIZE, plain,
+                              AES_BLOCK_SIZE, &out_len) == PSA_SUCCESS ? 0 : -1;
+}
+
+void aes_decrypt_deinit(void *ctx)
+{
+    psa_aes_deinit(ctx);
+}
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Stand-ins for the UICC library feature groups left out of the build
+ *
+ * The library command dispatch and context reset reference the CAT,
+ * SMS and OTA entry points unconditionally. When a group is disabled in
+ * Kconfig its sources are not compiled and the definitions below take
+ * their place: commands are refused, queues stay empty. Nothing here is
+ * reached in normal operation, softsim_transact() answers the commands
+ * of a disabled group before the dispatch. The prototypes come from the
+ * library headers, so a change of signature breaks the build.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <onomondo/softsim/softsim.h>
+
+#include "apdu.h"
+#include "proactive.h"
+#include "uicc_cat.h"
+#include "uicc_remote_cmd.h"
+#include "uicc_sms_rx.h"
+#include "uicc_sms_tx.h"
+
+/* TS 102 221 status word */
+#define SW_INS_NOT_SUPPORTED  0x6d00
+
+#ifndef CONFIG_SOFTSIM_CAT
+int ss_uicc_cat_cmd_term_profile(struct ss_apdu *apdu)
+{
+    return SW_INS_NOT_SUPPORTED;
+}
+
+int ss_uicc_cat_cmd_envelope(struct ss_apdu *apdu)
+{
+    return SW_INS_NOT_SUPPORTED;
+}
+
+int ss_uicc_cat_cmd_fetch(struct ss_apdu *apdu)
+{
+    return SW_INS_NOT_SUPPORTED;
+}
+
+int ss_uicc_cat_cmd_term_resp(struct ss_apdu *apdu)
+{
+    return SW_INS_NOT_SUPPORTED;
+}
+
+/* No proactive command is ever queued, the card never answers 91xx */
+bool ss_proactive_rts(const struct ss_context *ctx)
+{
+    return false;
+}
+
+int ss_proactive_put(struct ss_context *ctx, term_resp_cb term_resp_cb, const uint8_t *data,
+                     size_t len)
+{
+    return -1;
+}
+
+void ss_proactive_get(struct ss_context *ctx, uint8_t *data, size_t len)
+{
+}
+
+void ss_proactive_term_resp(struct ss_context *ctx, const uint8_t *data, size_t len)
+{
+}
+
+void ss_proactive_reset(struct ss_context *ctx)
+{
+}
+
+void ss_proactive_poll(struct ss_context *ctx)
+{
+}
+#endif /* !CONFIG_SOFTSIM_CAT */
+
+#ifndef CONFIG_SOFTSIM_SMS
+int ss_uicc_sms_rx(struct ss_context *ctx, uint8_t *sms_tpdu, size_t sms_tpdu_len)
+{
+    return -1;
+}
+
+void ss_uicc_sms_rx_clear(struct ss_context *ctx)
+{
+}
+
+int ss_uicc_sms_tx(struct ss_context *ctx, struct ss_sm_hdr *sm_hdr, uint8_t *ud_hdr,
+                   size_t ud_hdr_len, uint8_t *ud, size_t ud_len, sms_result_cb sms_result_cb)
+{
+    return -1;
+}
+
+void ss_uicc_sms_tx_clear(struct ss_context *ctx)
+{
+}
+
+void ss_uicc_sms_tx_poll(struct ss_context *ctx)
+{
+}
+#endif /* !CONFIG_SOFTSIM_SMS */
+
+#ifndef CONFIG_SOFTSIM_OTA
+/* utils_ota.c and utils_3des.c are only used by uicc_remote_cmd.c */
+int ss_uicc_remote_cmd_receive(size_t cmd_packet_len, uint8_t *cmd_packet,
+                               size_t *response_len, uint8_t response[])
+{
+    *response_len = 0;
+    return -1;
+}
+#endif /* !CONFIG_SOFTSIM_OTA */
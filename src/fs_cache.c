@@ -0,0 +1,220 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * RAM cache of file contents for the NVS storage backend
+ *
+ * After a reset the UICC library walks the file system again (MF, EF.DIR,
+ * ADF.USIM, ...) and loads every file definition and content it needs
+ * through ss_fopen(). The cache keeps those records in RAM so that warm
+ * resets and repeated selections do not go back to flash. Entries are
+ * updated on write and dropped on delete, and the least recently used
+ * ones are evicted when the byte budget is exceeded.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+struct fs_cache_entry {
+    uint16_t nvs_id;
+    uint16_t len;
+    uint32_t last_use;         /* Cache tick of the last hit, 0 = free */
+    uint8_t *data;
+};
+
+static struct fs_cache_entry cache[CONFIG_SOFTSIM_FILE_CACHE_ENTRIES];
+static size_t cache_bytes;
+static uint32_t cache_tick;
+static uint32_t cache_hits;
+static uint32_t cache_misses;
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static struct fs_cache_entry *cache_find(uint16_t nvs_id)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+        if (cache[i].last_use && cache[i].nvs_id == nvs_id) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void cache_drop(struct fs_cache_entry *e)
+{
+    cache_bytes -= e->len;
+    softsim_free(e->data);
+    memset(e, 0, sizeof(*e));
+}
+
+/* Least recently used entry, NULL if the cache is empty */
+static struct fs_cache_entry *cache_oldest(void)
+{
+    struct fs_cache_entry *lru = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+        if (cache[i].last_use && (!lru || cache[i].last_use < lru->last_use)) {
+            lru = &cache[i];
+        }
+    }
+    return lru;
+}
+
+/* Free entry, evicting the least recently used one if needed */
+static struct fs_cache_entry *cache_slot(void)
+{
+    struct fs_cache_entry *e;
+
+    for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+        if (!cache[i].last_use) {
+            return &cache[i];
+        }
+    }
+
+    e = cache_oldest();
+    cache_drop(e);
+    return e;
+}
+
+ssize_t softsim_fs_cache_get(uint16_t nvs_id, uint8_t *buf, size_t len)
+{
+    struct fs_cache_entry *e;
+    ssize_t ret = -ENOENT;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    e = cache_find(nvs_id);
+    if (e) {
+        if (buf) {
+            memcpy(buf, e->data, MIN(len, e->len));
+        }
+        e->last_use = ++cache_tick;
+        ret = e->len;
+        cache_hits++;
+    } else {
+        cache_misses++;
+    }
+
+    k_mutex_unlock(&cache_lock);
+
+    return ret;
+}
+
+void softsim_fs_cache_put(uint16_t nvs_id, const uint8_t *buf, size_t len)
+{
+    struct fs_cache_entry *e;
+    uint8_t *data;
+
+    if (len == 0 || len > CONFIG_SOFTSIM_FILE_CACHE_SIZE) {
+        softsim_fs_cache_invalidate(nvs_id);
+        return;
+    }
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    e = cache_find(nvs_id);
+    if (e) {
+        cache_drop(e);
+    }
+
+    /* Make room, oldest first */
+    while (cache_bytes + len > CONFIG_SOFTSIM_FILE_CACHE_SIZE) {
+        cache_drop(cache_oldest());
+    }
+
+    e = cache_slot();
+
+    data = softsim_malloc_persist(len);
+    if (!data) {
+        LOG_DBG("cache: no memory for id=%04x (%zu bytes)", nvs_id, len);
+        k_mutex_unlock(&cache_lock);
+        return;
+    }
+
+    memcpy(data, buf, len);
+    e->nvs_id = nvs_id;
+    e->len = len;
+    e->data = data;
+    e->last_use = ++cache_tick;
+    cache_bytes += len;
+
+    k_mutex_unlock(&cache_lock);
+}
+
+void softsim_fs_cache_invalidate(uint16_t nvs_id)
+{
+    struct fs_cache_entry *e;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    e = cache_find(nvs_id);
+    if (e) {
+        cache_drop(e);
+    }
+
+    k_mutex_unlock(&cache_lock);
+}
+
+void softsim_fs_cache_clear(void)
+{
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+        if (cache[i].last_use) {
+            cache_drop(&cache[i]);
+        }
+    }
+
+    k_mutex_unlock(&cache_lock);
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_cache_show(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t used = 0;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+        if (cache[i].last_use) {
+            used++;
+        }
+    }
+    shell_print(sh, "file cache: %zu/%d entries, %zu/%d bytes, %u hits, %u misses", used,
+                CONFIG_SOFTSIM_FILE_CACHE_ENTRIES, cache_bytes, CONFIG_SOFTSIM_FILE_CACHE_SIZE,
+                cache_hits, cache_misses);
+    k_mutex_unlock(&cache_lock);
+
+    return 0;
+}
+
+static int cmd_cache_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_fs_cache_clear();
+    shell_print(sh, "file cache cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_cache,
+    SHELL_CMD(show, NULL, "File cache usage", cmd_cache_show),
+    SHELL_CMD(clear, NULL, "Drop all cached files", cmd_cache_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), cache, &sub_cache, "Storage file cache", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
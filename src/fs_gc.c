@@ -0,0 +1,192 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Idle-time garbage collection of the soft SIM NVS partition
+ *
+ * nvs_write() closes the write sector and garbage collects the oldest one
+ * when the record does not fit, inside the ss_fclose() of whichever APDU
+ * happens to write then. A low priority thread moves to the next sector
+ * ahead of time, once no APDU has been seen for a while and the room left
+ * in the write sector drops below the configured headroom, so foreground
+ * writes find space without collecting. The thread leaves the partition
+ * alone until a user of the soft SIM has mounted it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/logging/log.h>
+
+#include <softsim/storage_gc.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/* NVS addresses: sector in the upper half, offset in the lower half */
+#define ADDR_OFFS_MASK 0xffff
+
+static atomic_t last_apdu;     /* Uptime of the last APDU, ms */
+static uint32_t blocked_wra;   /* Write position where collecting did not help */
+static uint32_t gc_runs;
+static uint32_t gc_last_us;
+static uint32_t gc_max_us;
+
+static K_MUTEX_DEFINE(gc_lock);
+
+void softsim_storage_gc_activity(void)
+{
+    atomic_set(&last_apdu, k_uptime_get_32());
+}
+
+/*
+ * Bytes nvs_write() can take in the write sector without collecting, and
+ * the allocation table write position they were computed at.
+ */
+static size_t gc_room(struct nvs_fs *nvs, uint32_t *ate_wra)
+{
+    size_t ate_size = ROUND_UP(sizeof(struct softsim_nvs_ate),
+                               nvs->flash_parameters->write_block_size);
+    size_t ate, data;
+
+    k_mutex_lock(&nvs->nvs_lock, K_FOREVER);
+    ate = nvs->ate_wra & ADDR_OFFS_MASK;
+    data = nvs->data_wra & ADDR_OFFS_MASK;
+    if (ate_wra) {
+        *ate_wra = nvs->ate_wra;
+    }
+    k_mutex_unlock(&nvs->nvs_lock);
+
+    /* The record needs its own entry and leaves room for a gc done entry */
+    return (ate > data + 2 * ate_size) ? ate - data - 2 * ate_size : 0;
+}
+
+static int gc_collect(struct nvs_fs *nvs, bool force)
+{
+    uint32_t start, us, wra;
+    size_t room;
+    int err;
+
+    k_mutex_lock(&gc_lock, K_FOREVER);
+
+    /* Do not wear the partition when collecting cannot free enough */
+    room = gc_room(nvs, &wra);
+    if (!force && (room >= CONFIG_SOFTSIM_GC_HEADROOM || wra == blocked_wra)) {
+        k_mutex_unlock(&gc_lock);
+        return 0;
+    }
+
+    start = k_cycle_get_32();
+    err = nvs_sector_use_next(nvs);
+    us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    if (err) {
+        k_mutex_unlock(&gc_lock);
+        LOG_ERR("NVS sector change failed: %d", err);
+        return err;
+    }
+
+    gc_runs++;
+    gc_last_us = us;
+    gc_max_us = MAX(gc_max_us, us);
+
+    room = gc_room(nvs, &wra);
+    if (room < CONFIG_SOFTSIM_GC_HEADROOM) {
+        blocked_wra = wra;
+        LOG_WRN("NVS: %zu bytes free in write sector after collecting, below %d",
+                room, CONFIG_SOFTSIM_GC_HEADROOM);
+    }
+
+    k_mutex_unlock(&gc_lock);
+
+    LOG_DBG("NVS collected in %u us", us);
+
+    return 1;
+}
+
+int softsim_storage_gc(bool force)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+
+    if (!nvs) {
+        return -ENODEV;
+    }
+    return gc_collect(nvs, force);
+}
+
+static void gc_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (;;) {
+        struct nvs_fs *nvs;
+
+        k_sleep(K_MSEC(CONFIG_SOFTSIM_GC_INTERVAL_MS));
+
+        if (k_uptime_get_32() - (uint32_t)atomic_get(&last_apdu) <
+            CONFIG_SOFTSIM_GC_IDLE_MS) {
+            continue;
+        }
+
+        /* Mounting would also provision, that is up to the application */
+        nvs = softsim_storage_nvs_mounted();
+        if (nvs) {
+            gc_collect(nvs, false);
+        }
+    }
+}
+
+K_THREAD_DEFINE(softsim_gc, CONFIG_SOFTSIM_GC_STACK_SIZE, gc_thread, NULL, NULL, NULL,
+                CONFIG_SOFTSIM_GC_PRIORITY, 0, 0);
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_gc_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!nvs) {
+        shell_error(sh, "storage not mounted");
+        return -ENODEV;
+    }
+
+    shell_print(sh, "write sector: %zu bytes before collecting (headroom %d)", gc_room(nvs, NULL),
+                CONFIG_SOFTSIM_GC_HEADROOM);
+    shell_print(sh, "partition:    %zd bytes free", nvs_calc_free_space(nvs));
+    shell_print(sh, "collections:  %u, last %u us, max %u us", gc_runs, gc_last_us, gc_max_us);
+
+    return 0;
+}
+
+static int cmd_gc_run(const struct shell *sh, size_t argc, char **argv)
+{
+    int ret;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    ret = softsim_storage_gc(true);
+    if (ret < 0) {
+        shell_error(sh, "collection failed: %d", ret);
+        return ret;
+    }
+
+    shell_print(sh, "collected in %u us", gc_last_us);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_gc,
+    SHELL_CMD(show, NULL, "Write sector room and collection times", cmd_gc_show),
+    SHELL_CMD(run, NULL, "Move to the next sector now", cmd_gc_run),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), gc, &sub_gc, "NVS background garbage collection", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
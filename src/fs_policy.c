@@ -0,0 +1,464 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Per-file persistence policy of the soft SIM NVS storage
+ *
+ * ss_fclose() writes every modified file through to flash by default.
+ * Files matched as volatile (location information refreshed on every
+ * attach, ...) keep their new content in RAM only: flash keeps the
+ * provisioned one, which comes back after a reboot. Files matched as
+ * write-back are kept in RAM too and written to flash after
+ * CONFIG_SOFTSIM_FS_WRITE_BACK_MS, so a burst of updates costs one flash
+ * write. Reads of the storage backend look here before the file cache
+ * and the flash. When no slot is left the file is written through.
+ *
+ * Security state (keys, PIN and PUK counters, SQN) is always written
+ * through, whatever the Kconfig lists and the runtime rules say: losing
+ * an update there would replay an authentication or reset a retry count.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <strings.h>
+
+#include <softsim/fs_policy.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define POLICY_MATCH_MAX 24
+
+#ifdef CONFIG_SOFTSIM_SQN_RING
+#define POLICY_SQN_PATH CONFIG_SOFTSIM_SQN_PATH
+#else
+#define POLICY_SQN_PATH ""
+#endif
+
+/* Files of the UICC library holding security state, always written through */
+static const char *const policy_protected[] = {
+    "3f00/a001",                   /* Ki and OPc */
+    "3f00/a003",                   /* PIN and PUK */
+    "3f00/a004",                   /* SQN array */
+    "3f00/a005",                   /* OTA keys */
+    POLICY_SQN_PATH,
+};
+
+struct policy_rule {
+    char match[POLICY_MATCH_MAX];  /* Empty = free */
+    enum softsim_fs_policy policy;
+};
+
+struct policy_file {
+    uint16_t nvs_id;
+    uint16_t len;
+    uint16_t capacity;             /* 0 = free */
+    uint8_t policy;
+    bool dirty;                    /* Write-back content not in flash yet */
+    uint8_t *data;
+};
+
+static struct policy_rule rules[CONFIG_SOFTSIM_FS_POLICY_RULES];
+static struct policy_file files[CONFIG_SOFTSIM_FS_POLICY_FILES];
+static uint32_t writes_saved;      /* Flash writes avoided */
+static uint32_t writes_through;    /* No slot left */
+
+static K_MUTEX_DEFINE(policy_lock);
+
+static void policy_flush_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(flush_work, policy_flush_handler);
+
+/* FID or path suffix, on a path component boundary */
+static bool policy_match(const char *path, const char *match, size_t mlen)
+{
+    size_t plen = strlen(path);
+
+    if (mlen == 0 || mlen > plen || strncasecmp(path + plen - mlen, match, mlen)) {
+        return false;
+    }
+    return plen == mlen || path[plen - mlen - 1] == '/';
+}
+
+/* Kconfig lists are separated by spaces or commas */
+static bool policy_list_match(const char *list, const char *path)
+{
+    size_t n;
+
+    while (*list) {
+        list += strspn(list, " ,");
+        n = strcspn(list, " ,");
+        if (policy_match(path, list, n)) {
+            return true;
+        }
+        list += n;
+    }
+    return false;
+}
+
+/* True if a rule on @p match would cover a protected file */
+static bool policy_protected_match(const char *match, size_t mlen)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(policy_protected); i++) {
+        if (policy_match(policy_protected[i], match, mlen)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool policy_protected_path(const char *path)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(policy_protected); i++) {
+        const char *p = policy_protected[i];
+
+        if (p[0] && policy_match(path, p, strlen(p))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Called with policy_lock held */
+static enum softsim_fs_policy policy_of(const char *path)
+{
+    if (policy_protected_path(path)) {
+        return SOFTSIM_FS_WRITE_THROUGH;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(rules); i++) {
+        if (rules[i].match[0] &&
+            policy_match(path, rules[i].match, strlen(rules[i].match))) {
+            return rules[i].policy;
+        }
+    }
+
+    if (policy_list_match(CONFIG_SOFTSIM_FS_VOLATILE, path)) {
+        return SOFTSIM_FS_VOLATILE;
+    }
+    if (policy_list_match(CONFIG_SOFTSIM_FS_WRITE_BACK, path)) {
+        return SOFTSIM_FS_WRITE_BACK;
+    }
+    return SOFTSIM_FS_WRITE_THROUGH;
+}
+
+static struct policy_file *policy_find(uint16_t id)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        if (files[i].capacity && files[i].nvs_id == id) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static void policy_release(struct policy_file *f)
+{
+    softsim_free(f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+int softsim_fs_policy_set(const char *match, enum softsim_fs_policy policy)
+{
+    struct policy_rule *free_rule = NULL;
+    size_t len = match ? strlen(match) : 0;
+
+    if (len == 0 || len >= POLICY_MATCH_MAX) {
+        return -EINVAL;
+    }
+    if (policy != SOFTSIM_FS_WRITE_THROUGH && policy_protected_match(match, len)) {
+        LOG_WRN("%s holds security state, kept write-through", match);
+        return -EPERM;
+    }
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(rules); i++) {
+        if (!strcasecmp(rules[i].match, match)) {
+            free_rule = &rules[i];
+            break;
+        }
+        if (!free_rule && !rules[i].match[0]) {
+            free_rule = &rules[i];
+        }
+    }
+
+    if (!free_rule) {
+        k_mutex_unlock(&policy_lock);
+        return -ENOMEM;
+    }
+
+    memcpy(free_rule->match, match, len + 1);
+    free_rule->policy = policy;
+
+    k_mutex_unlock(&policy_lock);
+
+    return 0;
+}
+
+ssize_t softsim_fs_policy_get(uint16_t id, uint8_t *buf, size_t len)
+{
+    struct policy_file *f;
+    ssize_t ret = -ENOENT;
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+
+    f = policy_find(id);
+    if (f) {
+        if (buf) {
+            memcpy(buf, f->data, MIN(len, f->len));
+        }
+        ret = f->len;
+    }
+
+    k_mutex_unlock(&policy_lock);
+
+    return ret;
+}
+
+int softsim_fs_policy_put(const char *path, uint16_t id, const uint8_t *buf, size_t len)
+{
+    enum softsim_fs_policy policy;
+    struct policy_file *f;
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+
+    policy = policy_of(path);
+    f = policy_find(id);
+
+    if (policy == SOFTSIM_FS_WRITE_THROUGH) {
+        /* The rule changed at runtime, flash gets the latest content */
+        if (f) {
+            policy_release(f);
+        }
+        k_mutex_unlock(&policy_lock);
+        return -EAGAIN;
+    }
+
+    for (size_t i = 0; !f && i < ARRAY_SIZE(files); i++) {
+        if (!files[i].capacity) {
+            f = &files[i];
+        }
+    }
+
+    if (f && f->capacity < len) {
+        uint8_t *data = softsim_malloc_persist(len);
+
+        if (data) {
+            softsim_free(f->data);
+            f->data = data;
+            f->capacity = len;
+        } else {
+            /* An older RAM copy must not shadow the flash any longer */
+            if (f->capacity) {
+                policy_release(f);
+            }
+            f = NULL;
+        }
+    }
+
+    if (!f) {
+        writes_through++;
+        k_mutex_unlock(&policy_lock);
+        LOG_WRN("No RAM slot for %s, written through", path);
+        return -EAGAIN;
+    }
+
+    memcpy(f->data, buf, len);
+    f->nvs_id = id;
+    f->len = len;
+    f->policy = policy;
+    writes_saved++;
+
+    if (policy == SOFTSIM_FS_WRITE_BACK) {
+        f->dirty = true;
+        /* Bounded lag: a pending flush is not pushed back */
+        k_work_schedule(&flush_work, K_MSEC(CONFIG_SOFTSIM_FS_WRITE_BACK_MS));
+    } else {
+        f->dirty = false;
+    }
+
+    k_mutex_unlock(&policy_lock);
+
+    /* Reads are served from here until the content reaches flash */
+    softsim_fs_cache_invalidate(id);
+    softsim_rsp_cache_invalidate();
+
+    LOG_DBG("%s (id=0x%04x) kept in RAM, %s", path, id,
+            policy == SOFTSIM_FS_WRITE_BACK ? "write-back" : "volatile");
+
+    return 0;
+}
+
+void softsim_fs_policy_drop(uint16_t id)
+{
+    struct policy_file *f;
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+    f = policy_find(id);
+    if (f) {
+        policy_release(f);
+    }
+    k_mutex_unlock(&policy_lock);
+}
+
+int softsim_fs_policy_flush(void)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    bool pending = false;
+    int err = 0;
+    uint32_t t;
+    ssize_t rc;
+
+    if (!nvs) {
+        /* Keep the content in RAM and try again later */
+        k_work_schedule(&flush_work, K_MSEC(CONFIG_SOFTSIM_FS_WRITE_BACK_MS));
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        struct policy_file *f = &files[i];
+
+        if (!f->capacity || !f->dirty) {
+            continue;
+        }
+
+        t = softsim_storage_op_begin(SOFTSIM_STORAGE_WRITE, f->nvs_id);
+        rc = softsim_storage_write(f->nvs_id, f->data, f->len);
+        softsim_storage_op_end(SOFTSIM_STORAGE_WRITE, f->nvs_id, t, rc);
+        if (rc < 0) {
+            LOG_ERR("Write-back of id 0x%04x failed: %d", f->nvs_id, (int)rc);
+            if (!err) {
+                err = rc;
+            }
+            pending = true;
+            continue;
+        }
+
+        /* In flash now, the file cache takes over */
+        softsim_fs_cache_put(f->nvs_id, f->data, f->len);
+        policy_release(f);
+    }
+
+    /* Whoever flushed, content left in RAM gets another try later */
+    if (pending) {
+        k_work_schedule(&flush_work, K_MSEC(CONFIG_SOFTSIM_FS_WRITE_BACK_MS));
+    }
+
+    k_mutex_unlock(&policy_lock);
+
+    return err;
+}
+
+int softsim_fs_sync(void)
+{
+    int err, ret;
+
+    k_work_cancel_delayable(&flush_work);
+
+    err = softsim_fs_policy_flush();
+    ret = softsim_wear_sync();
+
+    return err ? err : ret;
+}
+
+static void policy_flush_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    softsim_fs_policy_flush();
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static const char *const policy_names[] = {
+    [SOFTSIM_FS_WRITE_THROUGH] = "write-through",
+    [SOFTSIM_FS_WRITE_BACK] = "write-back",
+    [SOFTSIM_FS_VOLATILE] = "volatile",
+};
+
+static int cmd_fspolicy_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "volatile:   \"%s\"", CONFIG_SOFTSIM_FS_VOLATILE);
+    shell_print(sh, "write-back: \"%s\" (%d ms)", CONFIG_SOFTSIM_FS_WRITE_BACK,
+                CONFIG_SOFTSIM_FS_WRITE_BACK_MS);
+
+    k_mutex_lock(&policy_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(rules); i++) {
+        if (rules[i].match[0]) {
+            shell_print(sh, "rule:       %s %s", rules[i].match,
+                        policy_names[rules[i].policy]);
+        }
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        if (files[i].capacity) {
+            shell_print(sh, "0x%04x %5u bytes %s%s", files[i].nvs_id, files[i].len,
+                        policy_names[files[i].policy], files[i].dirty ? ", dirty" : "");
+        }
+    }
+    shell_print(sh, "flash writes saved: %u, written through (no slot): %u", writes_saved,
+                writes_through);
+
+    k_mutex_unlock(&policy_lock);
+
+    return 0;
+}
+
+static int cmd_fspolicy_set(const struct shell *sh, size_t argc, char **argv)
+{
+    int err;
+
+    ARG_UNUSED(argc);
+
+    for (size_t i = 0; i < ARRAY_SIZE(policy_names); i++) {
+        if (!strcmp(argv[2], policy_names[i])) {
+            err = softsim_fs_policy_set(argv[1], i);
+            if (err == -EPERM) {
+                shell_error(sh, "%s holds security state, it stays write-through", argv[1]);
+            } else if (err) {
+                shell_error(sh, "set failed: %d", err);
+            }
+            return err;
+        }
+    }
+
+    shell_error(sh, "policy: write-through, write-back or volatile");
+    return -EINVAL;
+}
+
+static int cmd_fspolicy_sync(const struct shell *sh, size_t argc, char **argv)
+{
+    int err;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    err = softsim_fs_sync();
+    if (err) {
+        shell_error(sh, "sync failed: %d", err);
+    }
+
+    return err;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_fspolicy,
+    SHELL_CMD(show, NULL, "Rules and files held in RAM", cmd_fspolicy_show),
+    SHELL_CMD_ARG(set, NULL, "<fid|path suffix> <write-through|write-back|volatile>",
+                  cmd_fspolicy_set, 3, 0),
+    SHELL_CMD(sync, NULL, "Write pending write-back files to flash", cmd_fspolicy_sync),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), fspolicy, &sub_fspolicy, "Per-file persistence policy", NULL, 1,
+                 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
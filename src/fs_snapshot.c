@@ -0,0 +1,515 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Storage snapshot export and import
+ *
+ * The files of the active profile are found by walking the NVS allocation
+ * table once, then read through the storage backend for their latest
+ * content. An import writes each file as soon as it is received, so a
+ * snapshot is restored in a single streaming pass without going through
+ * ss_fopen(). The files are staged in the spare range of the instance,
+ * which only becomes the active profile once the checksum has passed: a
+ * corrupted or truncated snapshot leaves the profile as it was.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+#include <softsim/snapshot.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define SNAPSHOT_MAGIC   "SSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HDR_LEN 8
+#define SNAPSHOT_REC_LEN 4
+#define SNAPSHOT_CRC_LEN 4
+
+/* Bitmap of the IDs of a profile */
+#define ID_MAP_SIZE (SOFTSIM_STORAGE_ID_SPAN / 8)
+
+enum import_state {
+    IMPORT_HEADER,
+    IMPORT_RECORD,
+    IMPORT_DATA,
+    IMPORT_CRC,
+    IMPORT_DONE,
+};
+
+struct softsim_snapshot_import {
+    enum import_state state;
+    int err;                   /* First error, sticky */
+    uint16_t base;             /* First NVS ID of the staging range */
+    uint16_t count;            /* Files announced by the header */
+    uint16_t done;             /* Files written */
+    uint16_t id;               /* Current file, relative ID */
+    uint16_t len;              /* Current file length */
+    size_t fill;               /* Bytes received of the current field */
+    uint32_t crc;
+    uint8_t field[SNAPSHOT_HDR_LEN];
+    uint8_t seen[ID_MAP_SIZE];
+    uint8_t data[CONFIG_SOFTSIM_MAX_FILE_SIZE];
+};
+
+struct snapshot_export {
+    softsim_snapshot_out_t out;
+    void *user;
+    uint32_t crc;
+    int size;
+};
+
+/* Profile range being walked and its ID bitmap */
+struct id_collect {
+    uint16_t base;
+    uint8_t *map;
+};
+
+static bool id_test(const uint8_t *map, uint16_t rel)
+{
+    return map[rel / 8] & BIT(rel % 8);
+}
+
+static void id_set(uint8_t *map, uint16_t rel)
+{
+    map[rel / 8] |= BIT(rel % 8);
+}
+
+/* Deleted IDs are collected too, reading them tells them apart */
+static int id_collect_cb(uint16_t id, uint32_t addr, uint16_t len, void *arg)
+{
+    struct id_collect *c = arg;
+
+    ARG_UNUSED(addr);
+    ARG_UNUSED(len);
+
+    if (id >= c->base && id - c->base < SOFTSIM_STORAGE_ID_SPAN) {
+        id_set(c->map, id - c->base);
+    }
+    return 0;
+}
+
+static int id_collect(uint16_t base, uint8_t *map)
+{
+    struct id_collect c = { .base = base, .map = map };
+
+    memset(map, 0, ID_MAP_SIZE);
+    return softsim_storage_ate_walk(id_collect_cb, &c);
+}
+
+/* Delete every record of a range, with what RAM holds of them */
+static int range_clear(uint16_t base)
+{
+    uint8_t *map = softsim_malloc(ID_MAP_SIZE);
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    uint32_t t;
+    int err;
+
+    if (!map) {
+        return -ENOMEM;
+    }
+
+    err = id_collect(base, map);
+
+    for (uint16_t rel = 0; rel < SOFTSIM_STORAGE_ID_SPAN && !err; rel++) {
+        uint16_t id = base + rel;
+
+        if (!id_test(map, rel)) {
+            continue;
+        }
+
+        softsim_fs_policy_drop(id);
+        softsim_fs_cache_invalidate(id);
+        softsim_sqn_ring_drop(id);
+        /* Already deleted records are not written again */
+        t = softsim_storage_op_begin(SOFTSIM_STORAGE_DELETE, id);
+        err = nvs_delete(nvs, id);
+        softsim_storage_op_end(SOFTSIM_STORAGE_DELETE, id, t, err);
+        if (err == -ENOENT) {
+            err = 0;
+        }
+    }
+
+    softsim_free(map);
+
+    return err;
+}
+
+static int snapshot_put(struct snapshot_export *exp, const void *data, size_t len)
+{
+    exp->crc = crc32_ieee_update(exp->crc, data, len);
+    exp->size += len;
+    return exp->out(data, len, exp->user);
+}
+
+int softsim_snapshot_export(softsim_snapshot_out_t out, void *user)
+{
+    struct snapshot_export exp = { .out = out, .user = user };
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    uint8_t hdr[SNAPSHOT_HDR_LEN];
+    uint16_t base, count = 0;
+    uint8_t *map, *buf;
+    ssize_t len;
+    int err;
+
+    if (!nvs) {
+        return -ENODEV;
+    }
+    base = softsim_storage_id_base();
+
+    /* Pending write-back files belong to the snapshot */
+    err = softsim_fs_policy_flush();
+    if (err) {
+        return err;
+    }
+
+    map = softsim_malloc(ID_MAP_SIZE);
+    buf = softsim_malloc(CONFIG_SOFTSIM_MAX_FILE_SIZE);
+    if (!map || !buf) {
+        err = -ENOMEM;
+        goto out;
+    }
+
+    err = id_collect(base, map);
+    if (err) {
+        goto out;
+    }
+
+    /* Keep the live files only, the header carries their count */
+    for (uint16_t rel = 0; rel < SOFTSIM_STORAGE_ID_SPAN; rel++) {
+        if (!id_test(map, rel)) {
+            continue;
+        }
+        if (softsim_storage_read(base + rel, NULL, 0) > 0) {
+            count++;
+        } else {
+            map[rel / 8] &= ~BIT(rel % 8);
+        }
+    }
+
+    memcpy(hdr, SNAPSHOT_MAGIC, 4);
+    hdr[4] = SNAPSHOT_VERSION;
+    hdr[5] = 0;
+    sys_put_le16(count, &hdr[6]);
+    err = snapshot_put(&exp, hdr, sizeof(hdr));
+
+    for (uint16_t rel = 0; rel < SOFTSIM_STORAGE_ID_SPAN && !err; rel++) {
+        if (!id_test(map, rel)) {
+            continue;
+        }
+
+        len = softsim_storage_read(base + rel, buf, CONFIG_SOFTSIM_MAX_FILE_SIZE);
+        if (len > CONFIG_SOFTSIM_MAX_FILE_SIZE) {
+            err = -EFBIG;
+            break;
+        }
+        if (len <= 0) {
+            /* Changed since the count, the snapshot would be inconsistent */
+            err = (len < 0) ? (int)len : -EAGAIN;
+            break;
+        }
+
+        sys_put_le16(rel, &hdr[0]);
+        sys_put_le16(len, &hdr[2]);
+        err = snapshot_put(&exp, hdr, SNAPSHOT_REC_LEN);
+        if (!err) {
+            err = snapshot_put(&exp, buf, len);
+        }
+    }
+
+    if (!err) {
+        sys_put_le32(exp.crc, hdr);
+        err = exp.out(hdr, SNAPSHOT_CRC_LEN, user);
+        exp.size += SNAPSHOT_CRC_LEN;
+    }
+
+out:
+    softsim_free(buf);
+    softsim_free(map);
+
+    if (err) {
+        LOG_ERR("Snapshot export failed: %d", err);
+        return err;
+    }
+
+    LOG_INF("Snapshot exported: %u files, %d bytes", count, exp.size);
+
+    return exp.size;
+}
+
+struct softsim_snapshot_import *softsim_snapshot_import_begin(void)
+{
+    struct softsim_snapshot_import *imp;
+
+    if (!softsim_storage_nvs() || softsim_storage_busy()) {
+        return NULL;
+    }
+
+    imp = softsim_malloc(sizeof(*imp));
+    if (!imp) {
+        return NULL;
+    }
+
+    memset(imp, 0, offsetof(struct softsim_snapshot_import, data));
+    imp->base = softsim_storage_spare_base();
+
+    /* Left over by an import that did not complete */
+    if (range_clear(imp->base)) {
+        softsim_free(imp);
+        return NULL;
+    }
+
+    return imp;
+}
+
+static int import_write(struct softsim_snapshot_import *imp)
+{
+    uint16_t id = imp->base + imp->id;
+    uint32_t t;
+    ssize_t rc;
+
+    softsim_fs_policy_drop(id);
+    softsim_fs_cache_invalidate(id);
+
+    t = softsim_storage_op_begin(SOFTSIM_STORAGE_WRITE, id);
+    rc = softsim_storage_write(id, imp->data, imp->len);
+    softsim_storage_op_end(SOFTSIM_STORAGE_WRITE, id, t, rc);
+
+    return (rc < 0) ? (int)rc : 0;
+}
+
+/* A field is complete, returns the next state */
+static enum import_state import_field(struct softsim_snapshot_import *imp)
+{
+    switch (imp->state) {
+    case IMPORT_HEADER:
+        if (memcmp(imp->field, SNAPSHOT_MAGIC, 4) || imp->field[4] != SNAPSHOT_VERSION) {
+            imp->err = -EBADMSG;
+            return IMPORT_HEADER;
+        }
+        imp->count = sys_get_le16(&imp->field[6]);
+        return imp->count ? IMPORT_RECORD : IMPORT_CRC;
+    case IMPORT_RECORD:
+        imp->id = sys_get_le16(&imp->field[0]);
+        imp->len = sys_get_le16(&imp->field[2]);
+        if (imp->id >= SOFTSIM_STORAGE_ID_SPAN || id_test(imp->seen, imp->id) ||
+            imp->len == 0 || imp->len > CONFIG_SOFTSIM_MAX_FILE_SIZE) {
+            imp->err = -EBADMSG;
+        }
+        return IMPORT_DATA;
+    case IMPORT_DATA:
+        imp->err = import_write(imp);
+        id_set(imp->seen, imp->id);
+        imp->done++;
+        return (imp->done < imp->count) ? IMPORT_RECORD : IMPORT_CRC;
+    case IMPORT_CRC:
+        if (sys_get_le32(imp->field) != imp->crc) {
+            imp->err = -EBADMSG;
+        }
+        return IMPORT_DONE;
+    default:
+        return IMPORT_DONE;
+    }
+}
+
+int softsim_snapshot_import_feed(struct softsim_snapshot_import *imp,
+                                 const uint8_t *data, size_t len)
+{
+    while (len > 0 && !imp->err) {
+        uint8_t *dst = imp->field;
+        size_t want, n;
+
+        switch (imp->state) {
+        case IMPORT_HEADER:
+            want = SNAPSHOT_HDR_LEN;
+            break;
+        case IMPORT_RECORD:
+            want = SNAPSHOT_REC_LEN;
+            break;
+        case IMPORT_DATA:
+            dst = imp->data;
+            want = imp->len;
+            break;
+        case IMPORT_CRC:
+            want = SNAPSHOT_CRC_LEN;
+            break;
+        default:
+            /* Trailing bytes */
+            imp->err = -EBADMSG;
+            continue;
+        }
+
+        n = MIN(len, want - imp->fill);
+        memcpy(dst + imp->fill, data, n);
+        if (imp->state != IMPORT_CRC) {
+            imp->crc = crc32_ieee_update(imp->crc, data, n);
+        }
+        imp->fill += n;
+        data += n;
+        len -= n;
+
+        if (imp->fill == want) {
+            imp->fill = 0;
+            imp->state = import_field(imp);
+        }
+    }
+
+    return imp->err;
+}
+
+int softsim_snapshot_import_end(struct softsim_snapshot_import *imp)
+{
+    int err = imp->err;
+
+    if (!err && imp->state != IMPORT_DONE) {
+        /* Truncated */
+        err = -EBADMSG;
+    }
+    if (!err) {
+        /* Verified: the staged files become the profile */
+        err = softsim_storage_spare_commit();
+    }
+
+    /* The staged files on error, the previous content of the profile else */
+    if (range_clear(softsim_storage_spare_base())) {
+        LOG_WRN("Spare range not cleared, the next import will");
+    }
+
+    if (err) {
+        LOG_ERR("Snapshot import failed after %u/%u files: %d", imp->done, imp->count, err);
+    } else {
+        LOG_INF("Snapshot imported: %u files", imp->done);
+        err = imp->done;
+    }
+
+    softsim_free(imp);
+
+    return err;
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+/* Hex lines of 32 bytes, as "softsim snapshot import" takes them back */
+struct snapshot_hex {
+    const struct shell *sh;
+    size_t fill;
+    char line[32 * 2 + 1];
+};
+
+static void snapshot_hex_flush(struct snapshot_hex *h)
+{
+    if (h->fill) {
+        h->line[2 * h->fill] = '\0';
+        shell_print(h->sh, "%s", h->line);
+        h->fill = 0;
+    }
+}
+
+static int snapshot_hex_out(const uint8_t *data, size_t len, void *user)
+{
+    static const char hex[] = "0123456789abcdef";
+    struct snapshot_hex *h = user;
+
+    for (size_t i = 0; i < len; i++) {
+        h->line[2 * h->fill] = hex[data[i] >> 4];
+        h->line[2 * h->fill + 1] = hex[data[i] & 0x0f];
+        if (++h->fill == 32) {
+            snapshot_hex_flush(h);
+        }
+    }
+
+    return 0;
+}
+
+static struct softsim_snapshot_import *shell_import;
+
+static int cmd_snapshot_export(const struct shell *sh, size_t argc, char **argv)
+{
+    struct snapshot_hex h = { .sh = sh };
+    int ret;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    ret = softsim_snapshot_export(snapshot_hex_out, &h);
+    snapshot_hex_flush(&h);
+    if (ret < 0) {
+        shell_error(sh, "export failed: %d", ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int cmd_snapshot_import(const struct shell *sh, size_t argc, char **argv)
+{
+    uint8_t buf[64];
+    size_t len;
+    int err;
+
+    if (!shell_import) {
+        shell_import = softsim_snapshot_import_begin();
+        if (!shell_import) {
+            shell_error(sh, "import not possible (files open or out of memory)");
+            return -EBUSY;
+        }
+    }
+
+    for (size_t i = 1; i < argc; i++) {
+        len = hex2bin(argv[i], strlen(argv[i]), buf, sizeof(buf));
+        if (len == 0) {
+            shell_error(sh, "invalid hex, at most %zu bytes per argument", sizeof(buf));
+            return -EINVAL;
+        }
+        err = softsim_snapshot_import_feed(shell_import, buf, len);
+        if (err) {
+            shell_error(sh, "import failed: %d, run \"commit\" to release it", err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+static int cmd_snapshot_commit(const struct shell *sh, size_t argc, char **argv)
+{
+    int ret;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!shell_import) {
+        shell_error(sh, "no import in progress");
+        return -EINVAL;
+    }
+
+    ret = softsim_snapshot_import_end(shell_import);
+    shell_import = NULL;
+    if (ret < 0) {
+        shell_error(sh, "import failed: %d", ret);
+        return ret;
+    }
+
+    shell_print(sh, "%d files restored, cold reset the soft SIM", ret);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_snapshot,
+    SHELL_CMD(export, NULL, "Print the active profile as a hex snapshot", cmd_snapshot_export),
+    SHELL_CMD_ARG(import, NULL, "Feed <hex>... of a snapshot", cmd_snapshot_import, 2, 8),
+    SHELL_CMD(commit, NULL, "Verify and finish the import", cmd_snapshot_commit),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), snapshot, &sub_snapshot, "Storage snapshot export/import",
+                 NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
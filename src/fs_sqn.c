@@ -0,0 +1,247 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Delta storage of the MILENAGE SQN file
+ *
+ * Every successful AUTHENTICATE rewrites the SQN array, yet only the
+ * entry of one index changes. The file record is kept as a base and
+ * the bytes that differ from it are written to a small delta record
+ * instead, so an authentication costs a few bytes of flash rather than
+ * the whole array. NVS appends both records round-robin through its
+ * sectors, which spreads the wear. Once the delta outgrows
+ * CONFIG_SOFTSIM_SQN_DELTA_MAX, the content is written as the new base
+ * and the delta is deleted. The record format is in sqn_delta.h.
+ *
+ * The checksum rules out an old delta left behind by a compaction that
+ * was interrupted before the delete: applied to the new base, it would
+ * roll the SQN back.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+#include "softsim_internal.h"
+#include "sqn_delta.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define SQN_RANGES (0x10000 / SOFTSIM_STORAGE_ID_SPAN)
+
+static uint32_t delta_writes;
+static uint32_t compactions;
+
+/* SQN file ID of each file range, 0 until computed */
+static uint16_t sqn_ids[SQN_RANGES];
+
+static K_MUTEX_DEFINE(sqn_lock);
+
+/* Called on every storage read and write, the path hash is done once */
+static bool sqn_owns(uint16_t id)
+{
+    unsigned int range = id / SOFTSIM_STORAGE_ID_SPAN;
+    uint16_t sqn_id = sqn_ids[range];
+
+    if (CONFIG_SOFTSIM_SQN_PATH[0] == '\0' || range == 0) {
+        return false;
+    }
+    if (sqn_id == 0) {
+        sqn_id = softsim_storage_file_id(range * SOFTSIM_STORAGE_ID_SPAN,
+                                         CONFIG_SOFTSIM_SQN_PATH);
+        sqn_ids[range] = sqn_id;
+    }
+    return id == sqn_id;
+}
+
+void softsim_sqn_ring_reset(void)
+{
+    memset(sqn_ids, 0, sizeof(sqn_ids));
+}
+
+static uint16_t sqn_delta_id(uint16_t id)
+{
+    return SOFTSIM_NVS_ID_SQN_DELTA + id / SOFTSIM_STORAGE_ID_SPAN;
+}
+
+ssize_t softsim_sqn_ring_apply(uint16_t id, void *buf, size_t len, ssize_t rc)
+{
+    uint8_t delta[CONFIG_SOFTSIM_SQN_DELTA_MAX];
+    struct nvs_fs *nvs;
+    uint8_t *rec = buf;
+    ssize_t dlen;
+
+    if (rc <= 0 || !buf || !sqn_owns(id)) {
+        return rc;
+    }
+
+    nvs = softsim_storage_nvs();
+    if (!nvs) {
+        return rc;
+    }
+
+    k_mutex_lock(&sqn_lock, K_FOREVER);
+
+    dlen = nvs_read(nvs, sqn_delta_id(id), delta, sizeof(delta));
+    if (dlen <= SQN_DELTA_HDR_LEN || dlen > (ssize_t)sizeof(delta)) {
+        goto out;
+    }
+
+    /* The base checksum needs the whole record */
+    if ((size_t)rc > len) {
+        rec = softsim_malloc_persist(rc);
+        if (!rec || softsim_storage_record_read(id, rec, rc) != rc) {
+            rc = -ENOMEM;
+            goto out;
+        }
+    }
+
+    if (sqn_delta_base_crc(delta) == crc32_ieee(rec, rc) &&
+        sqn_delta_walk(delta, dlen, rec, rc, false)) {
+        sqn_delta_walk(delta, dlen, rec, rc, true);
+    } else {
+        LOG_WRN("SQN delta 0x%04x does not match its base, ignored", sqn_delta_id(id));
+    }
+
+    if (rec != buf) {
+        memcpy(buf, rec, len);
+    }
+
+out:
+    if (rec != buf) {
+        softsim_free(rec);
+    }
+    k_mutex_unlock(&sqn_lock);
+
+    return rc;
+}
+
+ssize_t softsim_sqn_ring_write(uint16_t id, const void *buf, size_t len)
+{
+    uint8_t delta[CONFIG_SOFTSIM_SQN_DELTA_MAX];
+    uint16_t delta_id = sqn_delta_id(id);
+    struct nvs_fs *nvs;
+    uint8_t *base;
+    ssize_t rc;
+    int n;
+
+    if (!sqn_owns(id)) {
+        return -EAGAIN;
+    }
+
+    nvs = softsim_storage_nvs();
+    if (!nvs) {
+        return -ENODEV;
+    }
+
+    base = softsim_malloc_persist(len);
+    if (!base) {
+        return -ENOMEM;
+    }
+
+    k_mutex_lock(&sqn_lock, K_FOREVER);
+
+    rc = softsim_storage_record_read(id, base, len);
+    n = (rc == (ssize_t)len) ? sqn_delta_build(base, buf, len, delta, sizeof(delta)) : -ENOENT;
+
+    if (n > SQN_DELTA_HDR_LEN) {
+        rc = nvs_write(nvs, delta_id, delta, n);
+        if (rc > 0) {
+            delta_writes++;
+        }
+    } else if (n == SQN_DELTA_HDR_LEN) {
+        /* Back to the base content */
+        rc = nvs_delete(nvs, delta_id);
+    } else {
+        /* New file, new size or delta full: the content becomes the base */
+        rc = nvs_write(nvs, id, buf, len);
+        if (rc >= 0) {
+            int err = nvs_delete(nvs, delta_id);
+
+            /* A stale delta no longer matches the base checksum */
+            if (err) {
+                LOG_WRN("SQN delta 0x%04x not deleted: %d", delta_id, err);
+            }
+            compactions++;
+        }
+    }
+
+    k_mutex_unlock(&sqn_lock);
+    softsim_free(base);
+
+    return rc;
+}
+
+void softsim_sqn_ring_drop(uint16_t id)
+{
+    struct nvs_fs *nvs;
+
+    if (!sqn_owns(id)) {
+        return;
+    }
+
+    nvs = softsim_storage_nvs();
+    if (!nvs) {
+        return;
+    }
+
+    k_mutex_lock(&sqn_lock, K_FOREVER);
+    nvs_delete(nvs, sqn_delta_id(id));
+    k_mutex_unlock(&sqn_lock);
+}
+
+static int softsim_sqn_ring_init(void)
+{
+    if (CONFIG_SOFTSIM_SQN_PATH[0] == '\0') {
+        LOG_WRN("CONFIG_SOFTSIM_SQN_PATH is empty, SQN delta storage disabled");
+    }
+    return 0;
+}
+
+SYS_INIT(softsim_sqn_ring_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_sqn_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    ssize_t dlen;
+    uint16_t id;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!nvs) {
+        shell_error(sh, "storage not mounted");
+        return -ENODEV;
+    }
+    if (CONFIG_SOFTSIM_SQN_PATH[0] == '\0') {
+        shell_error(sh, "CONFIG_SOFTSIM_SQN_PATH not set");
+        return -ENOENT;
+    }
+
+    id = softsim_storage_file_id(softsim_storage_id_base(), CONFIG_SOFTSIM_SQN_PATH);
+
+    dlen = nvs_read(nvs, sqn_delta_id(id), NULL, 0);
+
+    shell_print(sh, "file:   %s (id=0x%04x), %zd bytes", CONFIG_SOFTSIM_SQN_PATH, id,
+                softsim_storage_record_read(id, NULL, 0));
+    shell_print(sh, "delta:  id=0x%04x, %zd/%d bytes", sqn_delta_id(id), MAX(dlen, 0),
+                CONFIG_SOFTSIM_SQN_DELTA_MAX);
+    shell_print(sh, "writes: %u deltas, %u compactions", delta_writes, compactions);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_sqn,
+    SHELL_CMD(show, NULL, "SQN file delta size and write counts", cmd_sqn_show),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), sqn, &sub_sqn, "SQN delta storage", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
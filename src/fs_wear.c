@@ -0,0 +1,434 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Flash wear statistics of the soft SIM NVS partition
+ *
+ * Every write and delete of the storage backend is accounted in flash
+ * bytes (data rounded to the write block plus the allocation entry), per
+ * NVS ID for the most written files. Sector erases are not visible from
+ * outside NVS: each time the write position moves to the next sector,
+ * NVS garbage collects and erases the sector after it, so erases are
+ * counted from the write position. The counters are kept in one NVS
+ * record, written periodically while they change and on softsim_fs_sync(),
+ * so that the statistics do not become a wear source themselves.
+ *
+ * The per-file table keeps the heaviest writers: when a new file finds it
+ * full, every count is aged by the smallest one (Misra-Gries) and the
+ * entries that drop to zero make room, so a file written often enough
+ * always gets in and the counts shown are lower bounds.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include <softsim/wear.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define WEAR_VERSION    1
+#define ADDR_SECT_SHIFT 16
+
+struct wear_file {
+    uint16_t nvs_id;           /* 0 = free */
+    uint16_t reserved;
+    uint32_t writes;
+    uint32_t bytes;
+};
+
+/* Persisted as is */
+struct wear_record {
+    uint8_t version;
+    uint8_t sectors;
+    uint16_t reserved;
+    uint32_t uptime_s;
+    uint64_t bytes;
+    uint32_t erases[SOFTSIM_NVS_SECTOR_COUNT];
+    struct wear_file files[CONFIG_SOFTSIM_WEAR_FILES];
+};
+
+static struct wear_record wear;
+static uint32_t boot_uptime_s; /* Counted before this boot */
+static uint32_t last_sector;   /* NVS write sector seen last */
+static bool loaded;
+static bool dirty;
+
+static K_MUTEX_DEFINE(wear_lock);
+
+static void wear_save_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(save_work, wear_save_handler);
+
+static uint32_t wear_uptime(void)
+{
+    return boot_uptime_s + (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+}
+
+static void wear_clear(void)
+{
+    memset(&wear, 0, sizeof(wear));
+    wear.version = WEAR_VERSION;
+    wear.sectors = SOFTSIM_NVS_SECTOR_COUNT;
+}
+
+/* Called with wear_lock held */
+static void wear_load(struct nvs_fs *nvs)
+{
+    if (loaded) {
+        return;
+    }
+
+    if (nvs_read(nvs, SOFTSIM_NVS_ID_WEAR, &wear, sizeof(wear)) != sizeof(wear) ||
+        wear.version != WEAR_VERSION || wear.sectors != SOFTSIM_NVS_SECTOR_COUNT) {
+        wear_clear();
+    }
+
+    boot_uptime_s = wear.uptime_s;
+    last_sector = nvs->ate_wra >> ADDR_SECT_SHIFT;
+    loaded = true;
+
+    k_work_schedule(&save_work, K_MINUTES(CONFIG_SOFTSIM_WEAR_SAVE_MIN));
+}
+
+/*
+ * Take the bytes of the least written entry, or of the new write if
+ * smaller, off every entry and off *bytes. Returns an entry freed for the
+ * new write, NULL if nothing is left of it.
+ */
+static struct wear_file *wear_file_age(uint32_t *bytes)
+{
+    struct wear_file *slot = NULL;
+    uint32_t age = *bytes;
+
+    for (size_t i = 0; i < ARRAY_SIZE(wear.files); i++) {
+        age = MIN(age, wear.files[i].bytes);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(wear.files); i++) {
+        struct wear_file *f = &wear.files[i];
+
+        if (f->bytes <= age) {
+            memset(f, 0, sizeof(*f));
+            slot = slot ? slot : f;
+            continue;
+        }
+        f->writes = ((uint64_t)f->writes * (f->bytes - age) + f->bytes / 2) / f->bytes;
+        f->bytes -= age;
+    }
+
+    *bytes -= age;
+    return *bytes ? slot : NULL;
+}
+
+static void wear_file_account(uint16_t id, uint32_t bytes)
+{
+    struct wear_file *f = NULL;
+    struct wear_file *slot = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(wear.files); i++) {
+        if (wear.files[i].nvs_id == id) {
+            f = &wear.files[i];
+            break;
+        }
+        if (!slot && wear.files[i].nvs_id == 0) {
+            slot = &wear.files[i];
+        }
+    }
+
+    if (!f) {
+        f = slot;
+        if (!f) {
+            f = wear_file_age(&bytes);
+            if (!f) {
+                return;
+            }
+        }
+        f->nvs_id = id;
+    }
+    f->writes++;
+    f->bytes += bytes;
+}
+
+static void wear_account(struct nvs_fs *nvs, uint16_t id, uint32_t bytes)
+{
+    uint32_t sector = nvs->ate_wra >> ADDR_SECT_SHIFT;
+
+    wear.bytes += bytes;
+    wear_file_account(id, bytes);
+
+    /* Moving to a sector erases the one after it, once collected */
+    while (last_sector != sector) {
+        last_sector = (last_sector + 1) % SOFTSIM_NVS_SECTOR_COUNT;
+        wear.erases[(last_sector + 1) % SOFTSIM_NVS_SECTOR_COUNT]++;
+    }
+}
+
+static size_t wear_ate_size(struct nvs_fs *nvs)
+{
+    return ROUND_UP(sizeof(struct softsim_nvs_ate), nvs->flash_parameters->write_block_size);
+}
+
+/* Called with wear_lock held */
+static int wear_store(struct nvs_fs *nvs)
+{
+    ssize_t rc;
+
+    wear.uptime_s = wear_uptime();
+    rc = nvs_write(nvs, SOFTSIM_NVS_ID_WEAR, &wear, sizeof(wear));
+    if (rc < 0) {
+        LOG_ERR("Failed to save wear statistics: %d", (int)rc);
+        return rc;
+    }
+
+    /* The record is part of the wear, counted in the next save */
+    if (rc > 0) {
+        wear_account(nvs, SOFTSIM_NVS_ID_WEAR,
+                     ROUND_UP(rc, nvs->flash_parameters->write_block_size) +
+                     wear_ate_size(nvs));
+    }
+    dirty = false;
+
+    return 0;
+}
+
+void softsim_wear_note(enum softsim_storage_op op, uint16_t id, int rc)
+{
+    struct nvs_fs *nvs;
+    uint32_t bytes;
+
+    /* nvs_write() returns 0 when the content is unchanged */
+    if (op == SOFTSIM_STORAGE_READ || rc < 0 || (op == SOFTSIM_STORAGE_WRITE && rc == 0)) {
+        return;
+    }
+
+    nvs = softsim_storage_nvs();
+    if (!nvs) {
+        return;
+    }
+
+    bytes = wear_ate_size(nvs);
+    if (op == SOFTSIM_STORAGE_WRITE) {
+        bytes += ROUND_UP(rc, nvs->flash_parameters->write_block_size);
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    wear_load(nvs);
+    wear_account(nvs, id, bytes);
+    dirty = true;
+    k_mutex_unlock(&wear_lock);
+}
+
+int softsim_wear_sync(void)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs_mounted();
+    int err = 0;
+
+    if (!nvs) {
+        return 0;
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    if (loaded && dirty) {
+        err = wear_store(nvs);
+    }
+    k_mutex_unlock(&wear_lock);
+
+    return err;
+}
+
+static void wear_save_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    softsim_wear_sync();
+    k_work_schedule(&save_work, K_MINUTES(CONFIG_SOFTSIM_WEAR_SAVE_MIN));
+}
+
+int softsim_wear_save(void)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    int err;
+
+    if (!nvs) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    wear_load(nvs);
+    err = wear_store(nvs);
+    k_mutex_unlock(&wear_lock);
+
+    return err;
+}
+
+void softsim_wear_reset(void)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+
+    if (!nvs) {
+        return;
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    wear_load(nvs);
+    wear_clear();
+    /* Restart the powered time from now */
+    boot_uptime_s = -(uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+    wear_store(nvs);
+    k_mutex_unlock(&wear_lock);
+}
+
+void softsim_wear_stats_get(struct softsim_wear_stats *stats)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    uint64_t equiv, left;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->lifetime_days = UINT32_MAX;
+    if (!nvs) {
+        return;
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    wear_load(nvs);
+
+    stats->uptime_s = MAX(wear_uptime(), 1);
+    stats->bytes = wear.bytes;
+    for (size_t i = 0; i < ARRAY_SIZE(wear.erases); i++) {
+        stats->erases += wear.erases[i];
+        stats->erases_max = MAX(stats->erases_max, wear.erases[i]);
+    }
+
+    k_mutex_unlock(&wear_lock);
+
+    stats->bytes_per_hour = stats->bytes * 3600 / stats->uptime_s;
+
+    /* Before the sectors cycle, every sector worth of bytes is an erase */
+    equiv = MAX(stats->erases, stats->bytes / SOFTSIM_NVS_SECTOR_SIZE);
+    stats->erases_per_day = equiv * 86400 / stats->uptime_s;
+
+    if (equiv == 0) {
+        return;
+    }
+    if (stats->erases_max >= CONFIG_SOFTSIM_WEAR_ENDURANCE) {
+        stats->lifetime_days = 0;
+        return;
+    }
+
+    /* Erases left in the partition at the average rate so far */
+    left = (uint64_t)(CONFIG_SOFTSIM_WEAR_ENDURANCE - stats->erases_max) *
+           SOFTSIM_NVS_SECTOR_COUNT;
+    stats->lifetime_days = MIN(left * stats->uptime_s / (equiv * 86400), UINT32_MAX - 1);
+}
+
+int softsim_wear_files_get(struct softsim_wear_file *files, int max)
+{
+    struct wear_file sorted[CONFIG_SOFTSIM_WEAR_FILES];
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    int n = 0;
+
+    if (!nvs) {
+        return 0;
+    }
+
+    k_mutex_lock(&wear_lock, K_FOREVER);
+    wear_load(nvs);
+    memcpy(sorted, wear.files, sizeof(sorted));
+    k_mutex_unlock(&wear_lock);
+
+    /* Selection of the most written, the table is small */
+    while (n < max) {
+        struct wear_file *best = NULL;
+
+        for (size_t i = 0; i < ARRAY_SIZE(sorted); i++) {
+            if (sorted[i].nvs_id && (!best || sorted[i].bytes > best->bytes)) {
+                best = &sorted[i];
+            }
+        }
+        if (!best) {
+            break;
+        }
+
+        files[n].nvs_id = best->nvs_id;
+        files[n].writes = best->writes;
+        files[n].bytes = best->bytes;
+        best->nvs_id = 0;
+        n++;
+    }
+
+    return n;
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_wear_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct softsim_wear_file files[CONFIG_SOFTSIM_WEAR_FILES];
+    struct softsim_wear_stats st;
+    int n;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_wear_stats_get(&st);
+    n = softsim_wear_files_get(files, ARRAY_SIZE(files));
+
+    shell_print(sh, "powered:  %u h", st.uptime_s / 3600);
+    shell_print(sh, "written:  %llu bytes, %u bytes/h", (unsigned long long)st.bytes,
+                st.bytes_per_hour);
+    shell_print(sh, "erases:   %u (most worn sector %u/%d), %u/day", st.erases, st.erases_max,
+                CONFIG_SOFTSIM_WEAR_ENDURANCE, st.erases_per_day);
+    if (st.lifetime_days == UINT32_MAX) {
+        shell_print(sh, "lifetime: no wear yet");
+    } else {
+        shell_print(sh, "lifetime: %u days left", st.lifetime_days);
+    }
+
+    shell_print(sh, "%6s %8s %10s", "id", "writes", "bytes");
+    for (int i = 0; i < n; i++) {
+        shell_print(sh, "0x%04x %8u %10u", files[i].nvs_id, files[i].writes, files[i].bytes);
+    }
+
+    return 0;
+}
+
+static int cmd_wear_save(const struct shell *sh, size_t argc, char **argv)
+{
+    int err;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    err = softsim_wear_save();
+    if (err) {
+        shell_error(sh, "save failed: %d", err);
+    }
+
+    return err;
+}
+
+static int cmd_wear_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_wear_reset();
+    shell_print(sh, "wear statistics reset");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_wear,
+    SHELL_CMD(show, NULL, "Wear counters, lifetime and most written files", cmd_wear_show),
+    SHELL_CMD(save, NULL, "Persist the counters now", cmd_wear_save),
+    SHELL_CMD(reset, NULL, "Reset the counters", cmd_wear_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), wear, &sub_wear, "Flash wear statistics", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
@@ -7,13 +7,27 @@
  *
  * This implements the fs.h interface using Zephyr's NVS storage.
  * Files are stored in NVS with IDs derived from path hashes.
+ *
+ * With CONFIG_SOFTSIM_PROFILES > 1 each profile owns its own NVS ID
+ * range and the path hash is mapped into the range of the active
+ * profile, so switching profiles copies nothing.
+ *
+ * With CONFIG_SOFTSIM_MULTI_INSTANCE the file handles and the ID ranges
+ * are per soft SIM instance. The fs.h calls carry no context, so the
+ * instance is the one bound to the calling thread.
+ *
+ * With CONFIG_SOFTSIM_STATIC_FILES_BIN the files of the build-time
+ * static profile blob that are missing from the active profile are
+ * written on first mount, straight from flash.
  */
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/storage/flash_map.h>
+#include <zephyr/drivers/flash.h>
 #include <zephyr/fs/nvs.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -21,6 +35,11 @@
 #include <onomondo/softsim/fs.h>
 #include <onomondo/softsim/storage.h>
 
+#include <softsim/profile.h>
+#include <softsim/static_files.h>
+
+#include "softsim_internal.h"
+
 LOG_MODULE_REGISTER(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
 
 /* NVS configuration - use partition manager's settings partition */
@@ -32,9 +51,6 @@ LOG_MODULE_REGISTER(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
 #error "No suitable storage partition found"
 #endif
 
-#define SOFTSIM_NVS_SECTOR_SIZE     4096
-#define SOFTSIM_NVS_SECTOR_COUNT    8  /* 32KB partition / 4KB sectors */
-
 /* Use Kconfig values if available, otherwise defaults */
 #ifndef CONFIG_SOFTSIM_MAX_FILE_SIZE
 #define CONFIG_SOFTSIM_MAX_FILE_SIZE 1536
@@ -44,9 +60,38 @@ LOG_MODULE_REGISTER(softsim_fs, CONFIG_SOFTSIM_LOG_LEVEL);
 #define CONFIG_SOFTSIM_MAX_OPEN_FILES 4
 #endif
 
-/* NVS ID range for softsim files */
+#ifndef CONFIG_SOFTSIM_PROFILES
+#define CONFIG_SOFTSIM_PROFILES 1
+#endif
+
+#ifndef CONFIG_SOFTSIM_INSTANCES
+#define CONFIG_SOFTSIM_INSTANCES 1
+#endif
+
+/*
+ * NVS ID range for softsim files, one per instance and profile, then one
+ * spare range per instance that snapshot imports are staged in
+ */
 #define NVS_ID_BASE 0x1000
 #define NVS_ID_MAX  0x1FFF
+#define NVS_ID_SPAN (NVS_ID_MAX - NVS_ID_BASE + 1)
+
+/* Ranges of an instance: its profiles, then the spare one if any */
+#define STORAGE_SLOTS (CONFIG_SOFTSIM_PROFILES + IS_ENABLED(CONFIG_SOFTSIM_SNAPSHOT))
+#define STORAGE_SPARE CONFIG_SOFTSIM_PROFILES
+
+/* Active profile and range map of each instance, below every range */
+#define NVS_ID_PROFILE 0x0F00
+
+/* Static profile provisioned marker of each instance and profile */
+#define NVS_ID_PROVISIONED 0x0F40
+
+/* 0x0F80: SOFTSIM_NVS_ID_WEAR, wear statistics of fs_wear.c */
+/* 0x0FC0: SOFTSIM_NVS_ID_SQN_DELTA, SQN file deltas of fs_sqn.c */
+
+BUILD_ASSERT(NVS_ID_SPAN == SOFTSIM_STORAGE_ID_SPAN);
+BUILD_ASSERT(NVS_ID_BASE + CONFIG_SOFTSIM_INSTANCES * STORAGE_SLOTS * NVS_ID_SPAN
+             <= 0x10000, "too many instances and profiles for the NVS ID space");
 
 /* File handle structure - simulates a file in memory */
 struct ss_file_handle {
@@ -60,18 +105,84 @@ struct ss_file_handle {
     bool is_open;              /* True if handle is in use */
 };
 
-/* Global NVS handle */
+/* Storage state of one soft SIM instance */
+struct softsim_storage {
+    struct ss_file_handle handles[CONFIG_SOFTSIM_MAX_OPEN_FILES];
+    uint8_t profile;           /* Active profile */
+    uint16_t id_base;          /* First NVS ID of the active profile */
+    uint8_t span[STORAGE_SLOTS];   /* Range of each profile, then the spare */
+};
+
+/* NVS_ID_PROFILE record. The first byte alone is the older format. */
+struct storage_record {
+    uint8_t profile;
+    uint8_t span[STORAGE_SLOTS];
+} __packed;
+
+/* Global NVS handle, shared by all instances */
 static struct nvs_fs softsim_nvs;
 static bool nvs_initialized = false;
+static K_MUTEX_DEFINE(nvs_init_lock);
 
-/* File handle pool */
-static struct ss_file_handle file_handles[CONFIG_SOFTSIM_MAX_OPEN_FILES];
+static struct softsim_storage storages[CONFIG_SOFTSIM_INSTANCES];
 
 /* Storage path (used by storage.c) */
 char storage_path[SS_STORAGE_PATH_MAX] = SS_STORAGE_PATH_DEFAULT;
 
-/* Simple hash function for path to NVS ID */
-static uint16_t path_to_nvs_id(const char *path)
+/* Initial range of a slot: existing layouts keep their IDs */
+static uint8_t storage_span_default(unsigned int instance, unsigned int slot)
+{
+    if (slot < CONFIG_SOFTSIM_PROFILES) {
+        return instance * CONFIG_SOFTSIM_PROFILES + slot;
+    }
+    return CONFIG_SOFTSIM_INSTANCES * CONFIG_SOFTSIM_PROFILES + instance;
+}
+
+static uint16_t storage_id_base(unsigned int instance, unsigned int slot)
+{
+    return NVS_ID_BASE + storages[instance].span[slot] * NVS_ID_SPAN;
+}
+
+/* Each range of the instance once, in any order */
+static bool storage_record_valid(unsigned int instance, const struct storage_record *rec)
+{
+    uint32_t own = 0, seen = 0;
+
+    if (rec->profile >= CONFIG_SOFTSIM_PROFILES) {
+        return false;
+    }
+    for (unsigned int i = 0; i < STORAGE_SLOTS; i++) {
+        own |= BIT(storage_span_default(instance, i));
+    }
+    for (unsigned int i = 0; i < STORAGE_SLOTS; i++) {
+        if (!(own & BIT(rec->span[i])) || (seen & BIT(rec->span[i]))) {
+            return false;
+        }
+        seen |= BIT(rec->span[i]);
+    }
+    return true;
+}
+
+static int storage_record_write(unsigned int instance, unsigned int profile,
+                                const uint8_t *span)
+{
+    struct storage_record rec = { .profile = profile };
+    ssize_t rc;
+
+    memcpy(rec.span, span, sizeof(rec.span));
+    rc = nvs_write(&softsim_nvs, NVS_ID_PROFILE + instance, &rec, sizeof(rec));
+
+    return (rc < 0) ? (int)rc : 0;
+}
+
+/* Storage of the instance bound to the calling thread */
+static struct softsim_storage *storage_current(void)
+{
+    return &storages[softsim_instance_current()];
+}
+
+/* Simple hash function for path to NVS ID in the range at id_base */
+static uint16_t path_id(uint16_t id_base, const char *path)
 {
     uint32_t hash = 5381;
     const char *p = path;
@@ -81,9 +192,92 @@ static uint16_t path_to_nvs_id(const char *path)
         p++;
     }
 
-    /* Map to NVS ID range */
-    return NVS_ID_BASE + (hash % (NVS_ID_MAX - NVS_ID_BASE));
+    return id_base + (hash % (NVS_ID_SPAN - 1));
+}
+
+/* Map to NVS ID range of the active profile */
+static uint16_t path_to_nvs_id(const char *path)
+{
+    return path_id(storage_current()->id_base, path);
+}
+
+#ifdef CONFIG_SOFTSIM_STATIC_FILES_BIN
+static int static_file_cmp(const void *key, const void *elem)
+{
+    return strcmp(key, ((const struct softsim_static_file *)elem)->name);
+}
+
+const uint8_t *softsim_static_file_get(const char *name, size_t *len)
+{
+    const struct softsim_static_file *f;
+
+    f = bsearch(name, softsim_static_files, softsim_static_files_count,
+                sizeof(softsim_static_files[0]), static_file_cmp);
+    if (!f) {
+        return NULL;
+    }
+
+    *len = f->len;
+    return &softsim_static_blob[f->offset];
+}
+
+/*
+ * Write the static files missing from the active profile of an instance.
+ * The marker holds the hash of the blob it was provisioned from: a
+ * firmware with other static files provisions again. On failure the
+ * marker is left as is and the next mount retries.
+ */
+static void storage_provision(unsigned int instance)
+{
+    const struct softsim_storage *st = &storages[instance];
+    uint16_t marker = NVS_ID_PROVISIONED + instance * CONFIG_SOFTSIM_PROFILES + st->profile;
+    char path[SS_STORAGE_PATH_MAX];
+    unsigned int written = 0;
+    uint32_t hash;
+    uint16_t id;
+    int err;
+
+    if (nvs_read(&softsim_nvs, marker, &hash, sizeof(hash)) == sizeof(hash) &&
+        hash == softsim_static_files_hash) {
+        return;
+    }
+
+    for (size_t i = 0; i < softsim_static_files_count; i++) {
+        const struct softsim_static_file *f = &softsim_static_files[i];
+
+        snprintf(path, sizeof(path), "%s/%s", storage_path, f->name);
+        id = path_id(st->id_base, path);
+
+        /* Keep files provisioned through the storage API */
+        if (nvs_read(&softsim_nvs, id, NULL, 0) >= 0) {
+            continue;
+        }
+
+        /* NVS copies from the source buffer, no RAM copy of the content */
+        err = nvs_write(&softsim_nvs, id, &softsim_static_blob[f->offset], f->len);
+        if (err < 0) {
+            LOG_ERR("Failed to provision %s: %d", path, err);
+            return;
+        }
+        written++;
+    }
+
+    hash = softsim_static_files_hash;
+    err = nvs_write(&softsim_nvs, marker, &hash, sizeof(hash));
+    if (err < 0) {
+        LOG_ERR("Failed to mark profile %u provisioned: %d", st->profile, err);
+        return;
+    }
+
+    LOG_INF("SoftSIM instance %u: %u/%zu static files provisioned in profile %u",
+            instance, written, softsim_static_files_count, st->profile);
+}
+#else
+static inline void storage_provision(unsigned int instance)
+{
+    ARG_UNUSED(instance);
 }
+#endif /* CONFIG_SOFTSIM_STATIC_FILES_BIN */
 
 /* Initialize NVS if not already done */
 static int ensure_nvs_init(void)
@@ -94,11 +288,18 @@ static int ensure_nvs_init(void)
         return 0;
     }
 
+    k_mutex_lock(&nvs_init_lock, K_FOREVER);
+    if (nvs_initialized) {
+        k_mutex_unlock(&nvs_init_lock);
+        return 0;
+    }
+
     LOG_INF("Initializing SoftSIM NVS storage - Copyright (c) Free Mobile");
 
     softsim_nvs.flash_device = FIXED_PARTITION_DEVICE(SOFTSIM_NVS_PARTITION_LABEL);
     if (!device_is_ready(softsim_nvs.flash_device)) {
         LOG_ERR("Flash device not ready");
+        k_mutex_unlock(&nvs_init_lock);
         return -ENODEV;
     }
 
@@ -112,21 +313,216 @@ static int ensure_nvs_init(void)
     err = nvs_mount(&softsim_nvs);
     if (err) {
         LOG_ERR("NVS mount failed: %d", err);
+        k_mutex_unlock(&nvs_init_lock);
         return err;
     }
 
+    for (int i = 0; i < CONFIG_SOFTSIM_INSTANCES; i++) {
+        struct storage_record rec;
+        ssize_t rc;
+
+        for (unsigned int slot = 0; slot < STORAGE_SLOTS; slot++) {
+            storages[i].span[slot] = storage_span_default(i, slot);
+        }
+
+        rc = nvs_read(&softsim_nvs, NVS_ID_PROFILE + i, &rec, sizeof(rec));
+        if (rc == sizeof(rec) && storage_record_valid(i, &rec)) {
+            storages[i].profile = rec.profile;
+            memcpy(storages[i].span, rec.span, sizeof(rec.span));
+        } else if (rc >= 1 && rec.profile < CONFIG_SOFTSIM_PROFILES) {
+            storages[i].profile = rec.profile;
+        }
+        storages[i].id_base = storage_id_base(i, storages[i].profile);
+        if (CONFIG_SOFTSIM_PROFILES > 1) {
+            LOG_INF("SoftSIM instance %d: profile %u active", i, storages[i].profile);
+        }
+        storage_provision(i);
+    }
+
     nvs_initialized = true;
     LOG_INF("SoftSIM NVS storage initialized successfully");
 
+    k_mutex_unlock(&nvs_init_lock);
+
     return 0;
 }
 
+struct nvs_fs *softsim_storage_nvs(void)
+{
+    return ensure_nvs_init() ? NULL : &softsim_nvs;
+}
+
+struct nvs_fs *softsim_storage_nvs_mounted(void)
+{
+    bool mounted;
+
+    k_mutex_lock(&nvs_init_lock, K_FOREVER);
+    mounted = nvs_initialized;
+    k_mutex_unlock(&nvs_init_lock);
+
+    return mounted ? &softsim_nvs : NULL;
+}
+
+uint16_t softsim_storage_id_base(void)
+{
+    ensure_nvs_init();
+    return storage_current()->id_base;
+}
+
+bool softsim_storage_busy(void)
+{
+    struct softsim_storage *st = storage_current();
+
+    for (int i = 0; i < CONFIG_SOFTSIM_MAX_OPEN_FILES; i++) {
+        if (st->handles[i].is_open) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t softsim_storage_file_id(uint16_t id_base, const char *name)
+{
+    char path[SS_STORAGE_PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/%s", storage_path, name);
+    return path_id(id_base, path);
+}
+
+ssize_t softsim_storage_record_read(uint16_t id, void *buf, size_t len)
+{
+    return nvs_read(&softsim_nvs, id, buf, len);
+}
+
+ssize_t softsim_storage_read(uint16_t id, void *buf, size_t len)
+{
+    return softsim_sqn_ring_apply(id, buf, len, softsim_storage_record_read(id, buf, len));
+}
+
+ssize_t softsim_storage_write(uint16_t id, const void *buf, size_t len)
+{
+    ssize_t rc = softsim_sqn_ring_write(id, buf, len);
+
+    if (rc == -EAGAIN) {
+        rc = nvs_write(&softsim_nvs, id, buf, len);
+    }
+    return rc;
+}
+
+static int storage_ate_read(uint32_t sector, uint32_t off, struct softsim_nvs_ate *ate)
+{
+    return flash_read(softsim_nvs.flash_device,
+                      softsim_nvs.offset + sector * softsim_nvs.sector_size + off,
+                      ate, sizeof(*ate));
+}
+
+static bool storage_ate_erased(const struct softsim_nvs_ate *ate)
+{
+    const uint8_t *p = (const uint8_t *)ate;
+
+    for (size_t i = 0; i < sizeof(*ate); i++) {
+        if (p[i] != 0xff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool storage_ate_valid(const struct softsim_nvs_ate *ate)
+{
+    return crc8_ccitt(0xff, ate, offsetof(struct softsim_nvs_ate, crc8)) == ate->crc8;
+}
+
+static int storage_ate_walk(softsim_storage_ate_cb cb, void *arg)
+{
+    uint32_t count = softsim_nvs.sector_count;
+    uint32_t size = softsim_nvs.sector_size;
+    uint32_t ate_size, write_sector = 0;
+    struct softsim_nvs_ate ate, close;
+    int err;
+
+    ate_size = ROUND_UP(sizeof(ate), softsim_nvs.flash_parameters->write_block_size);
+
+    /* Entries are appended to the open sector that follows a closed one */
+    for (uint32_t s = 0; s < count; s++) {
+        err = storage_ate_read(s, size - ate_size, &close);
+        if (err) {
+            return err;
+        }
+        if (storage_ate_erased(&close)) {
+            continue;
+        }
+        err = storage_ate_read((s + 1) % count, size - ate_size, &close);
+        if (err) {
+            return err;
+        }
+        if (storage_ate_erased(&close)) {
+            write_sector = (s + 1) % count;
+            break;
+        }
+    }
+
+    /* Oldest sector first, entries grow down from the top of each sector */
+    for (uint32_t i = 1; i <= count; i++) {
+        uint32_t s = (write_sector + i) % count;
+        uint32_t last = 0;
+
+        err = storage_ate_read(s, size - ate_size, &close);
+        if (err) {
+            return err;
+        }
+        if (!storage_ate_erased(&close) && storage_ate_valid(&close)) {
+            /* A closed sector records its lowest entry */
+            last = close.offset;
+        }
+
+        for (uint32_t off = size - 2 * ate_size; off >= last && off < size; off -= ate_size) {
+            err = storage_ate_read(s, off, &ate);
+            if (err) {
+                return err;
+            }
+            if (storage_ate_erased(&ate)) {
+                break;
+            }
+            /* 0xffff marks the sector close and gc done entries */
+            if (!storage_ate_valid(&ate) || ate.id == 0xffff) {
+                continue;
+            }
+            err = cb(ate.id, softsim_nvs.offset + s * size + ate.offset, ate.len, arg);
+            if (err) {
+                return (err < 0) ? err : 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int softsim_storage_ate_walk(softsim_storage_ate_cb cb, void *arg)
+{
+    int err;
+
+    err = ensure_nvs_init();
+    if (err) {
+        return err;
+    }
+
+    /* Writes and garbage collection move the sectors under the walk */
+    k_mutex_lock(&softsim_nvs.nvs_lock, K_FOREVER);
+    err = storage_ate_walk(cb, arg);
+    k_mutex_unlock(&softsim_nvs.nvs_lock);
+
+    return err;
+}
+
 /* Find a free file handle */
 static struct ss_file_handle *get_free_handle(void)
 {
+    struct softsim_storage *st = storage_current();
+
     for (int i = 0; i < CONFIG_SOFTSIM_MAX_OPEN_FILES; i++) {
-        if (!file_handles[i].is_open) {
-            return &file_handles[i];
+        if (!st->handles[i].is_open) {
+            return &st->handles[i];
         }
     }
     return NULL;
@@ -140,6 +536,7 @@ int ss_storage_set_path(const char *path)
 
     strncpy(storage_path, path, SS_STORAGE_PATH_MAX - 1);
     storage_path[SS_STORAGE_PATH_MAX - 1] = '\0';
+    softsim_sqn_ring_reset();
     return 0;
 }
 
@@ -148,7 +545,106 @@ const char *ss_storage_get_path(void)
     return storage_path;
 }
 
-ss_FILE ss_fopen(char *path, char *mode)
+int softsim_profile_select(unsigned int profile)
+{
+    unsigned int instance = softsim_instance_current();
+    struct softsim_storage *st = &storages[instance];
+    int err;
+
+    if (profile >= CONFIG_SOFTSIM_PROFILES) {
+        return -EINVAL;
+    }
+
+    err = ensure_nvs_init();
+    if (err) {
+        return err;
+    }
+
+    /* Open handles are bound to the IDs of the current profile */
+    if (softsim_storage_busy()) {
+        return -EBUSY;
+    }
+
+    if (profile == st->profile) {
+        return 0;
+    }
+
+    err = storage_record_write(instance, profile, st->span);
+    if (err) {
+        LOG_ERR("Failed to persist active profile: %d", err);
+        return err;
+    }
+
+    st->profile = profile;
+    st->id_base = storage_id_base(instance, profile);
+
+    storage_provision(instance);
+
+    /* File cache entries are keyed by NVS ID and stay valid */
+    softsim_rsp_cache_invalidate();
+    /* The Ki of the previous profile must not stay in RAM */
+    softsim_aes_key_cache_clear();
+
+    LOG_INF("SoftSIM instance %u: profile %u active", instance, profile);
+
+    return 0;
+}
+
+#ifdef CONFIG_SOFTSIM_SNAPSHOT
+uint16_t softsim_storage_spare_base(void)
+{
+    ensure_nvs_init();
+    return storage_id_base(softsim_instance_current(), STORAGE_SPARE);
+}
+
+int softsim_storage_spare_commit(void)
+{
+    unsigned int instance = softsim_instance_current();
+    struct softsim_storage *st = &storages[instance];
+    uint8_t span[STORAGE_SLOTS];
+    int err;
+
+    err = ensure_nvs_init();
+    if (err) {
+        return err;
+    }
+
+    /* Open handles are bound to the IDs of the current range */
+    if (softsim_storage_busy()) {
+        return -EBUSY;
+    }
+
+    memcpy(span, st->span, sizeof(span));
+    span[st->profile] = st->span[STORAGE_SPARE];
+    span[STORAGE_SPARE] = st->span[st->profile];
+
+    /* One record write: the profile is either the old or the new range */
+    err = storage_record_write(instance, st->profile, span);
+    if (err) {
+        LOG_ERR("Failed to switch to the imported range: %d", err);
+        return err;
+    }
+
+    memcpy(st->span, span, sizeof(span));
+    st->id_base = storage_id_base(instance, st->profile);
+
+    softsim_rsp_cache_invalidate();
+    softsim_aes_key_cache_clear();
+
+    LOG_INF("SoftSIM instance %u: profile %u now in range 0x%04x", instance, st->profile,
+            st->id_base);
+
+    return 0;
+}
+#endif /* CONFIG_SOFTSIM_SNAPSHOT */
+
+unsigned int softsim_profile_active(void)
+{
+    ensure_nvs_init();
+    return storage_current()->profile;
+}
+
+static ss_FILE fs_open_handle(char *path, char *mode)
 {
     struct ss_file_handle *handle;
     int err;
@@ -180,7 +676,7 @@ ss_FILE ss_fopen(char *path, char *mode)
     LOG_DBG("ss_fopen: path=%s mode=%s nvs_id=0x%04x", path, mode, handle->nvs_id);
 
     /* Allocate buffer */
-    handle->buffer = malloc(CONFIG_SOFTSIM_MAX_FILE_SIZE);
+    handle->buffer = softsim_malloc(CONFIG_SOFTSIM_MAX_FILE_SIZE);
     if (!handle->buffer) {
         LOG_ERR("Failed to allocate file buffer (%u bytes) for %s",
                 CONFIG_SOFTSIM_MAX_FILE_SIZE, path);
@@ -192,9 +688,22 @@ ss_FILE ss_fopen(char *path, char *mode)
     LOG_DBG("Allocated buffer %p for file %s", handle->buffer, path);
 
     if (strchr(mode, 'r') != NULL || strchr(mode, '+') != NULL) {
-        /* Read mode - try to load existing content */
-        ssize_t len = nvs_read(&softsim_nvs, handle->nvs_id,
-                              handle->buffer, CONFIG_SOFTSIM_MAX_FILE_SIZE);
+        /* Read mode - try to load existing content, from RAM if held or cached */
+        ssize_t len = softsim_fs_policy_get(handle->nvs_id, handle->buffer,
+                                            CONFIG_SOFTSIM_MAX_FILE_SIZE);
+        if (len < 0) {
+            len = softsim_fs_cache_get(handle->nvs_id, handle->buffer,
+                                       CONFIG_SOFTSIM_MAX_FILE_SIZE);
+        }
+        if (len < 0) {
+            uint32_t t = softsim_storage_op_begin(SOFTSIM_STORAGE_READ, handle->nvs_id);
+            len = softsim_storage_read(handle->nvs_id,
+                                       handle->buffer, CONFIG_SOFTSIM_MAX_FILE_SIZE);
+            softsim_storage_op_end(SOFTSIM_STORAGE_READ, handle->nvs_id, t, len);
+            if (len > 0) {
+                softsim_fs_cache_put(handle->nvs_id, handle->buffer, len);
+            }
+        }
         if (len > 0) {
             handle->size = len;
             LOG_DBG("Loaded file %s (id=%04x, size=%zu)", path, handle->nvs_id, handle->size);
@@ -204,7 +713,7 @@ ss_FILE ss_fopen(char *path, char *mode)
                 strchr(mode, 'w') == NULL) {
                 /* Read-only mode and file doesn't exist */
                 LOG_DBG("File not found: %s", path);
-                free(handle->buffer);
+                softsim_free(handle->buffer);
                 handle->buffer = NULL;
                 handle->is_open = false;
                 return NULL;
@@ -223,7 +732,7 @@ ss_FILE ss_fopen(char *path, char *mode)
     return (ss_FILE)handle;
 }
 
-int ss_fclose(ss_FILE f)
+static int fs_close_handle(ss_FILE f)
 {
     struct ss_file_handle *handle = (struct ss_file_handle *)f;
 
@@ -232,22 +741,27 @@ int ss_fclose(ss_FILE f)
         return -1;
     }
 
-    /* If modified, write back to NVS */
-    if (handle->modified && handle->size > 0) {
+    /* If modified, write back to NVS unless its policy keeps it in RAM */
+    if (handle->modified && handle->size > 0 &&
+        softsim_fs_policy_put(handle->path, handle->nvs_id,
+                              handle->buffer, handle->size) != 0) {
         LOG_DBG("ss_fclose: writing %s to NVS (id=0x%04x, size=%zu)",
                 handle->path, handle->nvs_id, handle->size);
-        int err = nvs_write(&softsim_nvs, handle->nvs_id,
-                           handle->buffer, handle->size);
+        uint32_t t = softsim_storage_op_begin(SOFTSIM_STORAGE_WRITE, handle->nvs_id);
+        int err = softsim_storage_write(handle->nvs_id, handle->buffer, handle->size);
+        softsim_storage_op_end(SOFTSIM_STORAGE_WRITE, handle->nvs_id, t, err);
         if (err < 0) {
             LOG_ERR("ss_fclose: NVS write FAILED for %s: %d", handle->path, err);
+            softsim_fs_cache_invalidate(handle->nvs_id);
         } else {
+            softsim_fs_cache_put(handle->nvs_id, handle->buffer, handle->size);
             LOG_DBG("ss_fclose: NVS write OK for %s (wrote %d bytes)",
                     handle->path, err);
         }
     }
 
     if (handle->buffer) {
-        free(handle->buffer);
+        softsim_free(handle->buffer);
         handle->buffer = NULL;
     }
 
@@ -256,6 +770,30 @@ int ss_fclose(ss_FILE f)
     return 0;
 }
 
+ss_FILE ss_fopen(char *path, char *mode)
+{
+    struct ss_file_handle *handle;
+
+    SOFTSIM_TRACE("ss_fopen_enter", path ? path_to_nvs_id(path) : 0, mode ? mode[0] : 0);
+    handle = fs_open_handle(path, mode);
+    SOFTSIM_TRACE("ss_fopen_exit", handle ? handle->nvs_id : 0, handle ? handle->size : 0);
+
+    return (ss_FILE)handle;
+}
+
+int ss_fclose(ss_FILE f)
+{
+    struct ss_file_handle *handle = (struct ss_file_handle *)f;
+    uint16_t nvs_id = (handle && handle->is_open) ? handle->nvs_id : 0;
+    int ret;
+
+    SOFTSIM_TRACE("ss_fclose_enter", nvs_id, handle ? handle->modified : 0);
+    ret = fs_close_handle(f);
+    SOFTSIM_TRACE("ss_fclose_exit", nvs_id, ret);
+
+    return ret;
+}
+
 size_t ss_fread(void *ptr, size_t size, size_t nmemb, ss_FILE f)
 {
     struct ss_file_handle *handle = (struct ss_file_handle *)f;
@@ -312,6 +850,7 @@ int ss_file_size(const char *path)
     int err;
     uint16_t nvs_id;
     ssize_t len;
+    uint32_t t;
 
     if (!path) {
         LOG_ERR("ss_file_size: NULL path");
@@ -327,7 +866,15 @@ int ss_file_size(const char *path)
     nvs_id = path_to_nvs_id(path);
 
     /* Query size without reading data - NVS returns length when buffer is NULL */
-    len = nvs_read(&softsim_nvs, nvs_id, NULL, 0);
+    len = softsim_fs_policy_get(nvs_id, NULL, 0);
+    if (len < 0) {
+        len = softsim_fs_cache_get(nvs_id, NULL, 0);
+    }
+    if (len < 0) {
+        t = softsim_storage_op_begin(SOFTSIM_STORAGE_READ, nvs_id);
+        len = softsim_storage_read(nvs_id, NULL, 0);
+        softsim_storage_op_end(SOFTSIM_STORAGE_READ, nvs_id, t, len);
+    }
     if (len < 0) {
         LOG_DBG("ss_file_size: file not found %s (id=%04x)", path, nvs_id);
         return -1;
@@ -341,6 +888,7 @@ int ss_delete_file(const char *path)
 {
     int err;
     uint16_t nvs_id;
+    uint32_t t;
 
     if (!path) {
         return -1;
@@ -353,7 +901,13 @@ int ss_delete_file(const char *path)
 
     nvs_id = path_to_nvs_id(path);
 
+    softsim_fs_policy_drop(nvs_id);
+    softsim_fs_cache_invalidate(nvs_id);
+    softsim_sqn_ring_drop(nvs_id);
+
+    t = softsim_storage_op_begin(SOFTSIM_STORAGE_DELETE, nvs_id);
     err = nvs_delete(&softsim_nvs, nvs_id);
+    softsim_storage_op_end(SOFTSIM_STORAGE_DELETE, nvs_id, t, err);
     if (err && err != -ENOENT) {
         LOG_ERR("Failed to delete file %s: %d", path, err);
         return -1;
@@ -410,6 +964,7 @@ int ss_access(const char *path, int amode)
     uint16_t nvs_id;
     uint8_t buf[1];
     ssize_t len;
+    uint32_t t;
 
     (void)amode;  /* Ignore access mode, just check existence */
 
@@ -425,7 +980,15 @@ int ss_access(const char *path, int amode)
     nvs_id = path_to_nvs_id(path);
 
     /* Check if entry exists */
-    len = nvs_read(&softsim_nvs, nvs_id, buf, sizeof(buf));
+    len = softsim_fs_policy_get(nvs_id, NULL, 0);
+    if (len < 0) {
+        len = softsim_fs_cache_get(nvs_id, NULL, 0);
+    }
+    if (len < 0) {
+        t = softsim_storage_op_begin(SOFTSIM_STORAGE_READ, nvs_id);
+        len = softsim_storage_read(nvs_id, buf, sizeof(buf));
+        softsim_storage_op_end(SOFTSIM_STORAGE_READ, nvs_id, t, len);
+    }
 
     return (len >= 0) ? 0 : -1;
 }
@@ -437,3 +1000,29 @@ int ss_create_dir(const char *path, uint32_t mode)
     (void)mode;
     return 0;
 }
+
+#if defined(CONFIG_SOFTSIM_SHELL) && CONFIG_SOFTSIM_PROFILES > 1
+#include <zephyr/shell/shell.h>
+
+static int cmd_profile(const struct shell *sh, size_t argc, char **argv)
+{
+    int err;
+
+    if (argc > 1) {
+        err = softsim_profile_select(strtoul(argv[1], NULL, 0));
+        if (err) {
+            shell_error(sh, "profile switch failed: %d", err);
+            return err;
+        }
+    }
+
+    shell_print(sh, "profile %u/%d active (NVS IDs 0x%04x-0x%04x)", softsim_profile_active(),
+                CONFIG_SOFTSIM_PROFILES, storage_current()->id_base,
+                storage_current()->id_base + NVS_ID_SPAN - 1);
+
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((softsim), profile, NULL, "Show or select [n] the active SIM profile",
+                 cmd_profile, 1, 1);
+#endif /* CONFIG_SOFTSIM_SHELL && CONFIG_SOFTSIM_PROFILES > 1 */
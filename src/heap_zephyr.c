@@ -0,0 +1,317 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Dedicated heap for the UICC library
+ *
+ * Without CONFIG_USE_SYSTEM_HEAP the library allocates through
+ * port_malloc()/port_free(). They are served from a k_heap of
+ * CONFIG_SOFTSIM_HEAP_SIZE bytes, so the soft SIM footprint is bounded
+ * and measurable, and its allocation latency does not depend on how
+ * other subsystems fragment the system heap.
+ *
+ * With CONFIG_SOFTSIM_ARENA, allocations made while softsim_transact()
+ * runs come from a bump allocator instead: most of them (TLV trees,
+ * response buffers, paths) are freed before the APDU completes, and the
+ * arena is then rewound in one go. An allocation that outlives its APDU
+ * pins the arena until it is freed; the next APDU uses the second arena,
+ * or the heap if both are pinned. State the module keeps across APDUs
+ * (file cache, RAM copies, key schedules) is allocated with
+ * softsim_malloc_persist(), which never uses the arena.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/sys_heap.h>
+
+#include <onomondo/softsim/mem.h>
+#include <softsim/heap.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_uicc, CONFIG_SOFTSIM_LOG_LEVEL);
+
+K_HEAP_DEFINE(softsim_heap, CONFIG_SOFTSIM_HEAP_SIZE);
+
+static atomic_t heap_allocs;
+static atomic_t heap_frees;
+static atomic_t heap_failures;
+
+#ifdef CONFIG_SOFTSIM_ARENA
+#define ARENA_ALIGN 8
+
+struct softsim_arena {
+    uint8_t buf[CONFIG_SOFTSIM_ARENA_SIZE] __aligned(ARENA_ALIGN);
+    size_t top;                /* Next free byte */
+    uint32_t live;             /* Allocations not freed yet */
+};
+
+static struct softsim_arena arenas[2];
+static struct softsim_arena *arena_cur;     /* NULL outside of an APDU */
+static k_tid_t arena_owner;                 /* Thread running the APDU */
+static k_tid_t arena_suspended;             /* Owner, while suspended */
+static struct k_spinlock arena_lock;
+
+static uint32_t arena_allocs;
+static uint32_t arena_fallbacks;            /* Did not fit, went to the heap */
+static uint32_t arena_pinned;               /* APDUs leaving allocations behind */
+
+static void *arena_alloc(size_t size)
+{
+    k_spinlock_key_t key = k_spin_lock(&arena_lock);
+    struct softsim_arena *a = arena_cur;
+    void *ptr = NULL;
+
+    /* Only the APDU thread uses the arena, others go to the heap */
+    if (a && arena_owner == k_current_get()) {
+        size = ROUND_UP(MAX(size, 1), ARENA_ALIGN);
+        if (a->top + size <= sizeof(a->buf)) {
+            ptr = &a->buf[a->top];
+            a->top += size;
+            a->live++;
+            arena_allocs++;
+        } else {
+            arena_fallbacks++;
+        }
+    }
+
+    k_spin_unlock(&arena_lock, key);
+
+    return ptr;
+}
+
+static bool arena_free(void *ptr)
+{
+    k_spinlock_key_t key;
+    bool found = false;
+
+    key = k_spin_lock(&arena_lock);
+
+    for (size_t i = 0; i < ARRAY_SIZE(arenas); i++) {
+        struct softsim_arena *a = &arenas[i];
+
+        if ((uint8_t *)ptr >= a->buf && (uint8_t *)ptr < a->buf + sizeof(a->buf)) {
+            /* Last survivor of a past APDU: the arena is free again */
+            if (--a->live == 0 && a != arena_cur) {
+                a->top = 0;
+            }
+            found = true;
+            break;
+        }
+    }
+
+    k_spin_unlock(&arena_lock, key);
+
+    return found;
+}
+
+void softsim_arena_begin(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&arena_lock);
+
+    /* Nested or concurrent APDU: the first one keeps the arena */
+    if (!arena_cur) {
+        for (size_t i = 0; i < ARRAY_SIZE(arenas); i++) {
+            if (arenas[i].live == 0) {
+                arenas[i].top = 0;
+                arena_cur = &arenas[i];
+                arena_owner = k_current_get();
+                break;
+            }
+        }
+    }
+
+    k_spin_unlock(&arena_lock, key);
+}
+
+void softsim_arena_end(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&arena_lock);
+
+    if (arena_cur && arena_owner == k_current_get()) {
+        if (arena_cur->live == 0) {
+            arena_cur->top = 0;
+        } else {
+            arena_pinned++;
+        }
+        arena_cur = NULL;
+        arena_owner = NULL;
+    }
+
+    k_spin_unlock(&arena_lock, key);
+}
+
+void softsim_arena_suspend(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&arena_lock);
+
+    if (arena_cur && arena_owner == k_current_get()) {
+        arena_suspended = arena_owner;
+        arena_owner = NULL;
+    }
+
+    k_spin_unlock(&arena_lock, key);
+}
+
+void softsim_arena_resume(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&arena_lock);
+
+    if (arena_suspended == k_current_get()) {
+        arena_owner = arena_suspended;
+        arena_suspended = NULL;
+    }
+
+    k_spin_unlock(&arena_lock, key);
+}
+#else
+static inline void *arena_alloc(size_t size)
+{
+    ARG_UNUSED(size);
+    return NULL;
+}
+
+static inline bool arena_free(void *ptr)
+{
+    ARG_UNUSED(ptr);
+    return false;
+}
+#endif /* CONFIG_SOFTSIM_ARENA */
+
+static void *heap_alloc(size_t size)
+{
+    void *ptr = k_heap_alloc(&softsim_heap, size, K_NO_WAIT);
+
+    if (ptr) {
+        atomic_inc(&heap_allocs);
+    } else {
+        atomic_inc(&heap_failures);
+        LOG_WRN("heap: failed to allocate %zu bytes", size);
+    }
+
+    return ptr;
+}
+
+void *softsim_mem_alloc(size_t size, bool persist)
+{
+    void *ptr = persist ? NULL : arena_alloc(size);
+
+    return ptr ? ptr : heap_alloc(size);
+}
+
+void softsim_mem_free(void *ptr)
+{
+    if (!ptr || arena_free(ptr)) {
+        return;
+    }
+
+    k_heap_free(&softsim_heap, ptr);
+    atomic_inc(&heap_frees);
+}
+
+/*
+ * Entry points of the UICC library. Not inlined: the allocation trace
+ * takes the caller as call site. The module allocates through
+ * softsim_mem_alloc() and is not traced.
+ */
+__noinline void *port_malloc(size_t size)
+{
+    void *ptr = softsim_mem_alloc(size, false);
+
+    if (ptr) {
+        softsim_alloc_trace_alloc(ptr, size, __builtin_return_address(0));
+    }
+
+    return ptr;
+}
+
+void port_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    softsim_alloc_trace_free(ptr);
+    softsim_mem_free(ptr);
+}
+
+void softsim_heap_stats_get(struct softsim_heap_stats *out)
+{
+    struct sys_memory_stats stats;
+
+    sys_heap_runtime_stats_get(&softsim_heap.heap, &stats);
+
+    out->size = CONFIG_SOFTSIM_HEAP_SIZE;
+    out->used = stats.allocated_bytes;
+    out->max_used = stats.max_allocated_bytes;
+    out->allocs = atomic_get(&heap_allocs);
+    out->frees = atomic_get(&heap_frees);
+    out->failures = atomic_get(&heap_failures);
+#ifdef CONFIG_SOFTSIM_ARENA
+    out->arena_allocs = arena_allocs;
+    out->arena_fallbacks = arena_fallbacks;
+    out->arena_pinned = arena_pinned;
+#else
+    out->arena_allocs = 0;
+    out->arena_fallbacks = 0;
+    out->arena_pinned = 0;
+#endif
+}
+
+void softsim_heap_stats_reset(void)
+{
+    sys_heap_runtime_stats_reset_max(&softsim_heap.heap);
+    atomic_clear(&heap_allocs);
+    atomic_clear(&heap_frees);
+    atomic_clear(&heap_failures);
+#ifdef CONFIG_SOFTSIM_ARENA
+    arena_allocs = 0;
+    arena_fallbacks = 0;
+    arena_pinned = 0;
+#endif
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_heap_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct softsim_heap_stats st;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_heap_stats_get(&st);
+
+    shell_print(sh, "heap: %zu/%zu bytes used, high-water %zu", st.used, st.size,
+                st.max_used);
+    shell_print(sh, "      %u allocs, %u frees, %u failures", st.allocs, st.frees,
+                st.failures);
+    if (IS_ENABLED(CONFIG_SOFTSIM_ARENA)) {
+        shell_print(sh, "arena: %u allocs, %u fallbacks, %u pinned APDUs", st.arena_allocs,
+                    st.arena_fallbacks, st.arena_pinned);
+    }
+
+    return 0;
+}
+
+static int cmd_heap_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_heap_stats_reset();
+    shell_print(sh, "heap statistics reset");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_heap,
+    SHELL_CMD(show, NULL, "Soft SIM heap usage", cmd_heap_show),
+    SHELL_CMD(reset, NULL, "Reset high-water mark and counters", cmd_heap_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), heap, &sub_heap, "Soft SIM heap", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
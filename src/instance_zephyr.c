@@ -0,0 +1,239 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Concurrent soft SIM instances
+ *
+ * Keeps two small tables: which instance each context belongs to, and
+ * which instance each thread is currently working for. The storage
+ * backend looks up the calling thread on every fs.h call; both tables
+ * are a handful of entries and scanned under a spinlock.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#include <onomondo/softsim/softsim.h>
+#include <softsim/instance.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/*
+ * Shared by all instances, sized for each to hold its live context and
+ * the replacement created by a cold reset
+ */
+#define CTX_SLOTS (2 * CONFIG_SOFTSIM_INSTANCES)
+
+struct thread_binding {
+    k_tid_t tid;               /* NULL = free */
+    uint8_t instance;
+    uint8_t depth;             /* Nested enter() calls */
+};
+
+struct ctx_binding {
+    struct ss_context *ctx;    /* NULL = free */
+    uint8_t instance;
+};
+
+static struct thread_binding threads[CONFIG_SOFTSIM_INSTANCE_THREADS];
+static struct ctx_binding contexts[CTX_SLOTS];
+static struct k_spinlock instance_lock;
+
+static struct thread_binding *thread_find(k_tid_t tid)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(threads); i++) {
+        if (threads[i].tid == tid) {
+            return &threads[i];
+        }
+    }
+    return NULL;
+}
+
+unsigned int softsim_instance_current(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+    struct thread_binding *b = thread_find(k_current_get());
+    unsigned int instance = b ? b->instance : 0;
+
+    k_spin_unlock(&instance_lock, key);
+
+    return instance;
+}
+
+unsigned int softsim_instance_of(struct ss_context *ctx)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+    unsigned int instance = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(contexts); i++) {
+        if (ctx && contexts[i].ctx == ctx) {
+            instance = contexts[i].instance;
+            break;
+        }
+    }
+
+    k_spin_unlock(&instance_lock, key);
+
+    return instance;
+}
+
+/* A nested bind remembers the instance to restore in *prev */
+static int bind(unsigned int instance, int *prev, bool nest)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+    struct thread_binding *b = thread_find(k_current_get());
+    int ret = 0;
+
+    if (b && !nest) {
+        ret = -EBUSY;
+    } else if (b) {
+        *prev = b->instance;
+        b->instance = instance;
+        b->depth++;
+    } else {
+        *prev = -1;
+        b = thread_find(NULL);
+        if (b) {
+            b->tid = k_current_get();
+            b->instance = instance;
+            b->depth = 1;
+        } else {
+            ret = -ENOMEM;
+        }
+    }
+
+    k_spin_unlock(&instance_lock, key);
+
+    return ret;
+}
+
+static void unbind(int prev)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+    struct thread_binding *b = thread_find(k_current_get());
+
+    if (b) {
+        if (--b->depth == 0) {
+            b->tid = NULL;
+        } else if (prev >= 0) {
+            b->instance = prev;
+        }
+    }
+
+    k_spin_unlock(&instance_lock, key);
+}
+
+int softsim_instance_enter(struct ss_context *ctx, int *prev)
+{
+    int err;
+
+    /*
+     * On failure the thread stays unbound and leave() has nothing to undo.
+     * Carrying on would reach the storage of instance 0, another SIM.
+     */
+    err = bind(softsim_instance_of(ctx), prev, true);
+    if (err) {
+        LOG_ERR("instance: no free thread binding, request refused");
+    }
+    return err;
+}
+
+void softsim_instance_leave(int prev)
+{
+    unbind(prev);
+}
+
+int softsim_instance_bind(unsigned int instance)
+{
+    int prev;
+
+    if (instance >= CONFIG_SOFTSIM_INSTANCES) {
+        return -EINVAL;
+    }
+    /* unbind() could not tell which instance to go back to */
+    return bind(instance, &prev, false);
+}
+
+void softsim_instance_unbind(void)
+{
+    unbind(-1);
+}
+
+int softsim_instance_register(struct ss_context *ctx, unsigned int instance)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+    int ret = -ENOMEM;
+
+    for (size_t i = 0; i < ARRAY_SIZE(contexts); i++) {
+        if (!contexts[i].ctx) {
+            contexts[i].ctx = ctx;
+            contexts[i].instance = instance;
+            ret = 0;
+            break;
+        }
+    }
+
+    k_spin_unlock(&instance_lock, key);
+
+    return ret;
+}
+
+void softsim_instance_unregister(struct ss_context *ctx)
+{
+    k_spinlock_key_t key = k_spin_lock(&instance_lock);
+
+    for (size_t i = 0; i < ARRAY_SIZE(contexts); i++) {
+        if (contexts[i].ctx == ctx) {
+            contexts[i].ctx = NULL;
+            break;
+        }
+    }
+
+    k_spin_unlock(&instance_lock, key);
+}
+
+struct ss_context *softsim_instance_new_ctx(unsigned int instance)
+{
+    struct ss_context *ctx;
+    int prev;
+
+    if (instance >= CONFIG_SOFTSIM_INSTANCES || bind(instance, &prev, true)) {
+        return NULL;
+    }
+    ctx = ss_new_ctx();
+    unbind(prev);
+
+    if (ctx && softsim_instance_register(ctx, instance)) {
+        LOG_ERR("instance: too many contexts");
+        ss_free_ctx(ctx);
+        ctx = NULL;
+    }
+
+    return ctx;
+}
+
+int softsim_instance_free_ctx(struct ss_context *ctx)
+{
+    int prev;
+    int err;
+
+    if (!ctx) {
+        return 0;
+    }
+
+    err = softsim_instance_enter(ctx, &prev);
+    if (err) {
+        return err;
+    }
+    ss_free_ctx(ctx);
+    softsim_instance_leave(prev);
+
+    softsim_instance_unregister(ctx);
+    softsim_aes_key_cache_clear();
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Built-in nRF modem softsim glue
+ *
+ * Registers the softsim request handler with the nRF modem library and
+ * serves it from a soft SIM context owned by the module:
+ *
+ * - INIT/RESET: warm reset of the existing context, answered with the
+ *   cached ATR; only the very first INIT creates the context
+ * - APDU: processed by softsim_transact(), the response is sent from the
+ *   request slot buffer
+ * - DEINIT: acknowledged, the context is kept for the next INIT
+ *
+ * PIN handling needs no dedicated request: VERIFY/CHANGE PIN reach the
+ * UICC as regular APDUs.
+ *
+ * The modem library calls the handler from its own callback context,
+ * where flash I/O and blocking locks are not allowed. Every request that
+ * touches the soft SIM is queued on the softsim work queue: APDUs through
+ * softsim_async_submit(), INIT/RESET each in a slot of their own so that
+ * a RESET arriving while another is pending is answered too.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <nrf_modem_softsim.h>
+
+#include <onomondo/softsim/softsim.h>
+#include <softsim/async.h>
+#include <softsim/nrf_modem.h>
+#include <softsim/transact.h>
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/* Set once on the work queue, read from the modem callback */
+static atomic_ptr_t sim_ctx;
+
+static K_MUTEX_DEFINE(glue_lock);
+
+/* Pending INIT/RESET requests, at most one per possible modem request */
+struct reset_req {
+    struct k_work work;
+    enum nrf_modem_softsim_cmd cmd;
+    uint16_t req_id;
+};
+
+K_MEM_SLAB_DEFINE_STATIC(reset_slab, ROUND_UP(sizeof(struct reset_req), sizeof(void *)),
+                         CONFIG_SOFTSIM_ASYNC_QUEUE_DEPTH, sizeof(void *));
+
+/* Called with glue_lock held, *fresh set if the context was just created */
+static struct ss_context *ctx_get_locked(bool *fresh)
+{
+    struct ss_context *ctx = atomic_ptr_get(&sim_ctx);
+
+    *fresh = (ctx == NULL);
+    if (!ctx) {
+        ctx = ss_new_ctx();
+        if (!ctx) {
+            LOG_ERR("Failed to allocate softsim context");
+        }
+        atomic_ptr_set(&sim_ctx, ctx);
+    }
+
+    return ctx;
+}
+
+struct ss_context *softsim_nrf_modem_ctx(void)
+{
+    struct ss_context *ctx;
+    bool fresh;
+
+    k_mutex_lock(&glue_lock, K_FOREVER);
+    ctx = ctx_get_locked(&fresh);
+    k_mutex_unlock(&glue_lock);
+
+    return ctx;
+}
+
+static void send_atr(struct ss_context *ctx, enum nrf_modem_softsim_cmd cmd, uint16_t req_id)
+{
+    const uint8_t *atr;
+    size_t atr_len = softsim_atr(ctx, &atr);
+
+    if (atr_len == 0) {
+        nrf_modem_softsim_err(cmd, req_id);
+        return;
+    }
+
+    nrf_modem_softsim_res(cmd, req_id, (void *)atr, atr_len);
+}
+
+static void apdu_done(int err, const uint8_t *rsp, size_t rsp_len, void *user_data)
+{
+    uint16_t req_id = (uint16_t)POINTER_TO_UINT(user_data);
+
+    if (err) {
+        nrf_modem_softsim_err(NRF_MODEM_SOFTSIM_APDU, req_id);
+        return;
+    }
+
+    nrf_modem_softsim_res(NRF_MODEM_SOFTSIM_APDU, req_id, (void *)rsp, rsp_len);
+}
+
+static void handle_apdu(uint16_t req_id, void *data, uint16_t data_len)
+{
+    /* Created by the INIT the modem always sends first */
+    struct ss_context *ctx = atomic_ptr_get(&sim_ctx);
+
+    if (!ctx || softsim_async_submit(ctx, data, data_len, apdu_done,
+                                     UINT_TO_POINTER(req_id))) {
+        nrf_modem_softsim_err(NRF_MODEM_SOFTSIM_APDU, req_id);
+    }
+}
+
+/*
+ * The modem resets the SIM several times per boot and on every CFUN
+ * toggle: INIT and RESET both keep the context and do a warm reset.
+ */
+static void do_reset(enum nrf_modem_softsim_cmd cmd, uint16_t req_id)
+{
+    struct ss_context *ctx;
+    bool fresh;
+
+    /* Creation and reset are one step against softsim_nrf_modem_ctx() */
+    k_mutex_lock(&glue_lock, K_FOREVER);
+    ctx = ctx_get_locked(&fresh);
+    if (ctx && !fresh) {
+        softsim_warm_reset(ctx);
+    }
+    k_mutex_unlock(&glue_lock);
+
+    if (!ctx) {
+        nrf_modem_softsim_err(cmd, req_id);
+        return;
+    }
+
+    send_atr(ctx, cmd, req_id);
+}
+
+/* Reset goes through the work queue too, behind any APDU still queued */
+static void reset_work_handler(struct k_work *work)
+{
+    struct reset_req *r = CONTAINER_OF(work, struct reset_req, work);
+
+    do_reset(r->cmd, r->req_id);
+    k_mem_slab_free(&reset_slab, r);
+}
+
+static void handle_reset(enum nrf_modem_softsim_cmd cmd, uint16_t req_id)
+{
+    struct reset_req *r;
+
+    if (k_mem_slab_alloc(&reset_slab, (void **)&r, K_NO_WAIT)) {
+        LOG_WRN("modem: too many pending resets");
+        nrf_modem_softsim_err(cmd, req_id);
+        return;
+    }
+
+    k_work_init(&r->work, reset_work_handler);
+    r->cmd = cmd;
+    r->req_id = req_id;
+    k_work_submit_to_queue(softsim_async_queue(), &r->work);
+}
+
+static void softsim_req_handler(enum nrf_modem_softsim_cmd req, uint16_t req_id, void *data,
+                                uint16_t data_len)
+{
+    switch (req) {
+    case NRF_MODEM_SOFTSIM_INIT:
+    case NRF_MODEM_SOFTSIM_RESET:
+        LOG_DBG("modem: %s", (req == NRF_MODEM_SOFTSIM_INIT) ? "INIT" : "RESET");
+        handle_reset(req, req_id);
+        break;
+
+    case NRF_MODEM_SOFTSIM_APDU:
+        handle_apdu(req_id, data, data_len);
+        break;
+
+    case NRF_MODEM_SOFTSIM_DEINIT:
+        LOG_DBG("modem: DEINIT");
+        nrf_modem_softsim_res(req, req_id, NULL, 0);
+        break;
+
+    default:
+        LOG_WRN("modem: unknown softsim request %d", req);
+        nrf_modem_softsim_err(req, req_id);
+        break;
+    }
+
+    if (data) {
+        nrf_modem_softsim_data_free(data);
+    }
+}
+
+static int softsim_nrf_modem_init(void)
+{
+    int err = nrf_modem_softsim_req_handler_set(softsim_req_handler);
+
+    if (err) {
+        LOG_ERR("Failed to register softsim request handler: %d", err);
+    }
+
+    return err;
+}
+
+SYS_INIT(softsim_nrf_modem_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
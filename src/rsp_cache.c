@@ -0,0 +1,476 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Response cache for idempotent SELECT and READ BINARY/RECORD commands
+ *
+ * During attach the modem repeats the same SELECT/READ sequences. Each
+ * logical channel tracks a 64-bit fingerprint of its selection state,
+ * derived from the commands that changed it since the last reset, and
+ * responses are cached under (channel, state, command bytes).
+ *
+ * A SELECT answered from the cache still has to change the selection in
+ * the UICC library. It is recorded as pending and replayed, response
+ * discarded, right before the next command that goes to the library.
+ *
+ * Any command outside the read-only set (UPDATE, PIN operations,
+ * AUTHENTICATE, ENVELOPE, TERMINAL RESPONSE for REFRESH, ...) and any
+ * write to storage, including OTA writes, drops all cached responses.
+ * Responses cached after a successful VERIFY are also dropped on reset,
+ * as the security status they depend on does not survive it.
+ *
+ * Each soft SIM instance has its own view (context, channel states);
+ * entries are tagged with the instance they belong to.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <onomondo/softsim/softsim.h>
+#include <softsim/transact.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_DECLARE(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+#define INS_SELECT        0xa4
+#define INS_STATUS        0xf2
+#define INS_READ_BINARY   0xb0
+#define INS_READ_RECORD   0xb2
+#define INS_SEARCH_RECORD 0xa2
+#define INS_GET_RESPONSE  0xc0
+#define INS_VERIFY        0x20
+
+#define SW_OK             0x9000
+#define SW_FILE_NOT_FOUND 0x6a82
+
+/* Basic channel and the three standard logical channels */
+#define CACHE_CHANNELS    4
+
+#ifndef CONFIG_SOFTSIM_INSTANCES
+#define CONFIG_SOFTSIM_INSTANCES 1
+#endif
+/* Longest cached command: SELECT by 16-byte AID with Le */
+#define CMD_KEY_MAX       24
+#define PENDING_MAX       8
+
+#define FNV64_OFFSET      0xcbf29ce484222325ULL
+#define FNV64_PRIME       0x100000001b3ULL
+
+/* Selection state right after a reset: MF selected on the basic channel */
+#define STATE_ROOT        FNV64_OFFSET
+
+struct rsp_cache_entry {
+    uint64_t state;            /* Channel state the response applies to */
+    uint64_t next_state;       /* Channel state after the command */
+    uint32_t last_use;         /* 0 = free */
+    uint16_t rsp_len;
+    uint8_t instance;
+    uint8_t ch;
+    uint8_t cmd_len;
+    bool pin_dep;              /* Cached while a PIN was verified */
+    uint8_t cmd[CMD_KEY_MAX];
+    uint8_t rsp[CONFIG_SOFTSIM_RSP_CACHE_RSP_MAX];
+};
+
+struct rsp_cache_channel {
+    uint64_t state;
+    uint8_t n_pending;
+    uint8_t pending_len[PENDING_MAX];
+    uint8_t pending[PENDING_MAX][CMD_KEY_MAX];
+};
+
+/* What the cache knows about the UICC state of one instance */
+struct rsp_cache_view {
+    struct ss_context *ctx;
+    bool pin_verified;
+    struct rsp_cache_channel channels[CACHE_CHANNELS];
+};
+
+static struct rsp_cache_entry entries[CONFIG_SOFTSIM_RSP_CACHE_ENTRIES];
+static struct rsp_cache_view views[CONFIG_SOFTSIM_INSTANCES];
+static uint32_t cache_tick;
+static uint32_t cache_hits;
+static uint32_t cache_misses;
+static uint32_t cache_replays;
+static uint32_t cache_flushes;
+
+/* Replayed SELECT responses are discarded here */
+static uint8_t replay_buf[SOFTSIM_APDU_RSP_MAX];
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static uint64_t state_next(uint64_t state, const uint8_t *cmd, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        state ^= cmd[i];
+        state *= FNV64_PRIME;
+    }
+    return state;
+}
+
+/* ETSI TS 102 221 clause 10.1.1: logical channel from CLA */
+static int cla_channel(uint8_t cla)
+{
+    if (cla & 0x40) {
+        return 4 + (cla & 0x0f);
+    }
+    return cla & 0x03;
+}
+
+static bool select_is_absolute(const uint8_t *cmd, size_t len)
+{
+    /* By DF name (AID), by path from MF, or MF itself */
+    if (cmd[2] == 0x04 || cmd[2] == 0x08) {
+        return true;
+    }
+    return cmd[2] == 0x00 && len >= 7 && cmd[4] == 2 && cmd[5] == 0x3f && cmd[6] == 0x00;
+}
+
+/* Commands whose response only depends on the selection state */
+static bool cmd_cacheable(const uint8_t *cmd, size_t len)
+{
+    if (len < 4 || len > CMD_KEY_MAX || cla_channel(cmd[0]) >= CACHE_CHANNELS) {
+        return false;
+    }
+
+    switch (cmd[1]) {
+    case INS_SELECT:
+        /* By FID, DF name, path from MF or from current DF */
+        return cmd[2] == 0x00 || cmd[2] == 0x04 || cmd[2] == 0x08 || cmd[2] == 0x09;
+    case INS_READ_BINARY:
+        /* Not by SFI: that would also change the current EF */
+        return !(cmd[2] & 0x80);
+    case INS_READ_RECORD:
+        /* Absolute/current mode on the current EF: no record pointer change */
+        return (cmd[3] & 0x07) == 0x04 && (cmd[3] >> 3) == 0;
+    default:
+        return false;
+    }
+}
+
+/* Read-only commands that never invalidate cached responses */
+static bool cmd_read_only(uint8_t ins)
+{
+    switch (ins) {
+    case INS_SELECT:
+    case INS_STATUS:
+    case INS_READ_BINARY:
+    case INS_READ_RECORD:
+    case INS_SEARCH_RECORD:
+    case INS_GET_RESPONSE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void entries_flush(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+        entries[i].last_use = 0;
+    }
+    cache_flushes++;
+}
+
+static void channels_reset(struct rsp_cache_view *v)
+{
+    memset(v->channels, 0, sizeof(v->channels));
+    for (size_t i = 0; i < ARRAY_SIZE(v->channels); i++) {
+        v->channels[i].state = STATE_ROOT + i;
+    }
+}
+
+/* Move every channel to a state no cached entry refers to */
+static void channels_advance(struct rsp_cache_view *v, const uint8_t *cmd, size_t len)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(v->channels); i++) {
+        v->channels[i].state = state_next(v->channels[i].state, cmd, len);
+    }
+}
+
+static void view_drop(unsigned int instance, bool pin_dep_only)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+        if (entries[i].instance == instance && (entries[i].pin_dep || !pin_dep_only)) {
+            entries[i].last_use = 0;
+        }
+    }
+}
+
+static struct rsp_cache_entry *entry_find(unsigned int instance, int ch, uint64_t state,
+                                          const uint8_t *cmd, size_t len)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+        struct rsp_cache_entry *e = &entries[i];
+
+        if (e->last_use && e->state == state && e->instance == instance && e->ch == ch &&
+            e->cmd_len == len && memcmp(e->cmd, cmd, len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static struct rsp_cache_entry *entry_slot(void)
+{
+    struct rsp_cache_entry *lru = &entries[0];
+
+    for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+        if (!entries[i].last_use) {
+            return &entries[i];
+        }
+        if (entries[i].last_use < lru->last_use) {
+            lru = &entries[i];
+        }
+    }
+    return lru;
+}
+
+static struct rsp_cache_view *view_get(struct ss_context *ctx, unsigned int *instance)
+{
+    struct rsp_cache_view *v;
+
+    *instance = softsim_instance_of(ctx);
+    v = &views[*instance];
+
+    /* A new context of the instance starts from scratch */
+    if (ctx != v->ctx) {
+        view_drop(*instance, false);
+        channels_reset(v);
+        v->pin_verified = false;
+        v->ctx = ctx;
+    }
+
+    return v;
+}
+
+size_t softsim_rsp_cache_lookup(struct ss_context *ctx, uint8_t *rsp, size_t rsp_len,
+                                const uint8_t *req, size_t req_len)
+{
+    struct rsp_cache_view *v;
+    struct rsp_cache_channel *c;
+    struct rsp_cache_entry *e;
+    unsigned int instance;
+    size_t len = 0;
+    int ch;
+
+    if (!cmd_cacheable(req, req_len)) {
+        return 0;
+    }
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    v = view_get(ctx, &instance);
+    ch = cla_channel(req[0]);
+    c = &v->channels[ch];
+
+    e = entry_find(instance, ch, c->state, req, req_len);
+    if (!e || e->rsp_len > rsp_len) {
+        cache_misses++;
+        goto out;
+    }
+
+    if (e->next_state != c->state) {
+        if (c->n_pending == PENDING_MAX) {
+            /* Let this one through, it flushes the pending list */
+            cache_misses++;
+            goto out;
+        }
+        memcpy(c->pending[c->n_pending], req, req_len);
+        c->pending_len[c->n_pending] = req_len;
+        c->n_pending++;
+        c->state = e->next_state;
+    }
+
+    memcpy(rsp, e->rsp, e->rsp_len);
+    len = e->rsp_len;
+    e->last_use = ++cache_tick;
+    cache_hits++;
+
+out:
+    k_mutex_unlock(&cache_lock);
+
+    return len;
+}
+
+void softsim_rsp_cache_forward(struct ss_context *ctx)
+{
+    struct rsp_cache_view *v;
+    unsigned int instance;
+    bool desync = false;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    v = view_get(ctx, &instance);
+
+    for (size_t ch = 0; ch < ARRAY_SIZE(v->channels); ch++) {
+        struct rsp_cache_channel *c = &v->channels[ch];
+
+        for (size_t i = 0; i < c->n_pending; i++) {
+            size_t req_len = c->pending_len[i];
+            size_t len;
+
+            len = ss_transact(ctx, replay_buf, sizeof(replay_buf), c->pending[i], &req_len);
+            cache_replays++;
+
+            if (len < 2 || replay_buf[len - 2] != 0x90 || replay_buf[len - 1] != 0x00) {
+                LOG_WRN("rsp cache: replayed SELECT on channel %zu failed", ch);
+                desync = true;
+            }
+        }
+        c->n_pending = 0;
+    }
+
+    if (desync) {
+        /* The library no longer matches our view: start over */
+        view_drop(instance, false);
+        channels_advance(v, (const uint8_t *)"desync", 6);
+    }
+
+    k_mutex_unlock(&cache_lock);
+}
+
+void softsim_rsp_cache_update(struct ss_context *ctx, const uint8_t *req, size_t req_len,
+                              const uint8_t *rsp, size_t rsp_len)
+{
+    uint16_t sw = (rsp_len >= 2) ? ((uint16_t)rsp[rsp_len - 2] << 8) | rsp[rsp_len - 1] : 0;
+    struct rsp_cache_view *v;
+    struct rsp_cache_channel *c;
+    struct rsp_cache_entry *e;
+    unsigned int instance;
+    uint64_t next;
+    uint8_t ins;
+    int ch;
+
+    if (req_len < 4) {
+        return;
+    }
+
+    ins = req[1];
+    ch = cla_channel(req[0]);
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    v = view_get(ctx, &instance);
+
+    if (!cmd_read_only(ins)) {
+        /* May have changed files, security status or channels */
+        entries_flush();
+        channels_advance(v, req, req_len);
+        if (ins == INS_VERIFY && sw == SW_OK) {
+            v->pin_verified = true;
+        }
+        goto out;
+    }
+
+    if (ch >= CACHE_CHANNELS) {
+        goto out;
+    }
+    c = &v->channels[ch];
+
+    if (ins == INS_SELECT && (sw == SW_OK || (sw >> 8) == 0x61)) {
+        next = state_next(select_is_absolute(req, req_len) ? STATE_ROOT + ch : c->state,
+                          req, req_len);
+    } else if (ins == INS_STATUS || ins == INS_GET_RESPONSE || ins == INS_SELECT ||
+               cmd_cacheable(req, req_len)) {
+        next = c->state;
+    } else {
+        /* SFI access, record pointer move, search: selection may change */
+        next = state_next(c->state, req, req_len);
+    }
+
+    if (cmd_cacheable(req, req_len) && rsp_len <= CONFIG_SOFTSIM_RSP_CACHE_RSP_MAX &&
+        (sw == SW_OK || (ins == INS_SELECT && sw == SW_FILE_NOT_FOUND)) &&
+        !entry_find(instance, ch, c->state, req, req_len)) {
+        e = entry_slot();
+        e->state = c->state;
+        e->next_state = next;
+        e->instance = instance;
+        e->ch = ch;
+        e->cmd_len = req_len;
+        memcpy(e->cmd, req, req_len);
+        e->rsp_len = rsp_len;
+        memcpy(e->rsp, rsp, rsp_len);
+        e->pin_dep = v->pin_verified;
+        e->last_use = ++cache_tick;
+    }
+
+    c->state = next;
+
+out:
+    k_mutex_unlock(&cache_lock);
+}
+
+void softsim_rsp_cache_reset(struct ss_context *ctx)
+{
+    struct rsp_cache_view *v;
+    unsigned int instance;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    v = view_get(ctx, &instance);
+
+    /* Pending selections are void: the UICC is back on MF */
+    channels_reset(v);
+
+    /* The security status is lost on reset */
+    view_drop(instance, true);
+    v->pin_verified = false;
+
+    k_mutex_unlock(&cache_lock);
+}
+
+void softsim_rsp_cache_invalidate(void)
+{
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    entries_flush();
+    k_mutex_unlock(&cache_lock);
+}
+
+#ifdef CONFIG_SOFTSIM_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_rsp_cache_show(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t used = 0;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+        if (entries[i].last_use) {
+            used++;
+        }
+    }
+    shell_print(sh, "response cache: %zu/%d entries, %u hits, %u misses, %u replays, %u flushes",
+                used, CONFIG_SOFTSIM_RSP_CACHE_ENTRIES, cache_hits, cache_misses,
+                cache_replays, cache_flushes);
+    k_mutex_unlock(&cache_lock);
+
+    return 0;
+}
+
+static int cmd_rsp_cache_flush(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    softsim_rsp_cache_invalidate();
+    shell_print(sh, "response cache flushed");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_rsp_cache,
+    SHELL_CMD(show, NULL, "Response cache usage", cmd_rsp_cache_show),
+    SHELL_CMD(flush, NULL, "Drop all cached responses", cmd_rsp_cache_flush),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((softsim), rspcache, &sub_rsp_cache, "APDU response cache", NULL, 1, 0);
+#endif /* CONFIG_SOFTSIM_SHELL */
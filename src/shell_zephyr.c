@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Zephyr shell root command for the soft SIM module
+ *
+ * Features add their own subcommands with SHELL_SUBCMD_ADD((softsim), ...)
+ * from their source file, so only what is enabled in Kconfig shows up.
+ */
+
+#include <zephyr/shell/shell.h>
+
+SHELL_SUBCMD_SET_CREATE(softsim_cmds, (softsim));
+
+SHELL_CMD_REGISTER(softsim, &softsim_cmds, "Soft SIM commands", NULL);
@@ -0,0 +1,527 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Internal hooks shared between the Zephyr platform sources
+ *
+ * Optional features are compiled in through Kconfig. When a feature is
+ * disabled its hooks collapse to empty inline functions so the callers
+ * in the transaction and storage paths stay free of #ifdefs.
+ */
+
+#ifndef SOFTSIM_INTERNAL_H_
+#define SOFTSIM_INTERNAL_H_
+
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct ss_context;
+
+/* Parsed view of a short C-APDU as handed to ss_transact() */
+struct softsim_apdu_info {
+    const uint8_t *cmd;        /* Raw command bytes */
+    size_t cmd_len;            /* Raw command length */
+    const uint8_t *rsp;        /* Response data followed by SW1 SW2 */
+    size_t rsp_len;            /* Response length including SW */
+    uint32_t cycles;           /* Time spent in ss_transact() */
+    uint16_t sw;               /* Status word, 0 if response too short */
+};
+
+/* NVS calls made by the storage backend */
+enum softsim_storage_op {
+    SOFTSIM_STORAGE_READ,
+    SOFTSIM_STORAGE_WRITE,
+    SOFTSIM_STORAGE_DELETE,
+    SOFTSIM_STORAGE_OP_COUNT
+};
+
+/*
+ * Allocations of the module follow the UICC library heap, without going
+ * through port_malloc(): the allocation trace only sees library sites.
+ * softsim_malloc_persist() is for state kept across APDUs, never served
+ * by the per-APDU arena. Both are released with softsim_free().
+ */
+#ifdef CONFIG_SOFTSIM_HEAP
+void *softsim_mem_alloc(size_t size, bool persist);
+void softsim_mem_free(void *ptr);
+#define softsim_malloc(size)         softsim_mem_alloc(size, false)
+#define softsim_malloc_persist(size) softsim_mem_alloc(size, true)
+#define softsim_free(ptr)            softsim_mem_free(ptr)
+#else
+#include <stdlib.h>
+#define softsim_malloc(size)         malloc(size)
+#define softsim_malloc_persist(size) malloc(size)
+#define softsim_free(ptr)            free(ptr)
+#endif
+
+static inline uint8_t softsim_apdu_ins(const uint8_t *cmd, size_t cmd_len)
+{
+    return (cmd_len >= 2) ? cmd[1] : 0;
+}
+
+static inline uint8_t softsim_apdu_lc(const uint8_t *cmd, size_t cmd_len)
+{
+    /* Case 3/4 short APDU: CLA INS P1 P2 Lc data [Le] */
+    return (cmd_len > 5) ? cmd[4] : 0;
+}
+
+#ifdef CONFIG_SOFTSIM_ARENA
+/* Route the allocations of the calling thread to the per-APDU arena */
+void softsim_arena_begin(void);
+void softsim_arena_end(void);
+/* Library allocations that outlive the APDU go to the heap meanwhile */
+void softsim_arena_suspend(void);
+void softsim_arena_resume(void);
+#else
+static inline void softsim_arena_begin(void)
+{
+}
+
+static inline void softsim_arena_end(void)
+{
+}
+
+static inline void softsim_arena_suspend(void)
+{
+}
+
+static inline void softsim_arena_resume(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_ALLOC_TRACE
+void softsim_alloc_trace_alloc(void *ptr, size_t size, void *site);
+void softsim_alloc_trace_free(void *ptr);
+void softsim_alloc_trace_apdu_begin(uint8_t ins);
+void softsim_alloc_trace_apdu_end(void);
+#else
+static inline void softsim_alloc_trace_alloc(void *ptr, size_t size, void *site)
+{
+    (void)ptr;
+    (void)size;
+    (void)site;
+}
+
+static inline void softsim_alloc_trace_free(void *ptr)
+{
+    (void)ptr;
+}
+
+static inline void softsim_alloc_trace_apdu_begin(uint8_t ins)
+{
+    (void)ins;
+}
+
+static inline void softsim_alloc_trace_apdu_end(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_APDU_TRACE
+void softsim_apdu_trace_record(const struct softsim_apdu_info *info);
+#else
+static inline void softsim_apdu_trace_record(const struct softsim_apdu_info *info)
+{
+    (void)info;
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_APDU_PCAP
+void softsim_apdu_pcap_record(const struct softsim_apdu_info *info);
+#else
+static inline void softsim_apdu_pcap_record(const struct softsim_apdu_info *info)
+{
+    (void)info;
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_APDU_STATS
+/* The calling thread starts an APDU, its storage time is counted for it */
+void softsim_apdu_stats_begin(void);
+void softsim_apdu_stats_record(const struct softsim_apdu_info *info);
+void softsim_apdu_stats_storage(enum softsim_storage_op op, uint32_t cycles);
+#else
+static inline void softsim_apdu_stats_begin(void)
+{
+}
+
+static inline void softsim_apdu_stats_record(const struct softsim_apdu_info *info)
+{
+    (void)info;
+}
+
+static inline void softsim_apdu_stats_storage(enum softsim_storage_op op, uint32_t cycles)
+{
+    (void)op;
+    (void)cycles;
+}
+#endif
+
+/* NVS geometry of the storage partition */
+#define SOFTSIM_NVS_SECTOR_SIZE     4096
+#define SOFTSIM_NVS_SECTOR_COUNT    8  /* 32KB partition / 4KB sectors */
+
+/* NVS IDs of one profile, see fs_zephyr.c */
+#define SOFTSIM_STORAGE_ID_SPAN 0x1000
+
+/* Wear statistics record, below the file ranges like the profile records */
+#define SOFTSIM_NVS_ID_WEAR 0x0F80
+
+/* SQN delta records, one per file range: base + NVS ID / SOFTSIM_STORAGE_ID_SPAN */
+#define SOFTSIM_NVS_ID_SQN_DELTA 0x0FC0
+
+struct nvs_fs;
+
+/* Allocation table entry, as laid out by the NVS subsystem */
+struct softsim_nvs_ate {
+    uint16_t id;
+    uint16_t offset;           /* Data offset in the sector */
+    uint16_t len;
+    uint8_t part;
+    uint8_t crc8;
+} __packed;
+
+/* Called with an allocation table entry and the flash offset of its data */
+typedef int (*softsim_storage_ate_cb)(uint16_t id, uint32_t addr, uint16_t len, void *arg);
+
+/* Storage backend NVS, mounted on first use, NULL if that fails */
+struct nvs_fs *softsim_storage_nvs(void);
+
+/* Storage backend NVS if already mounted, NULL otherwise, never mounts */
+struct nvs_fs *softsim_storage_nvs_mounted(void);
+
+/* First NVS ID of the active profile of the calling thread's instance */
+uint16_t softsim_storage_id_base(void);
+
+/* True if the calling thread's instance has open files */
+bool softsim_storage_busy(void);
+
+#ifdef CONFIG_SOFTSIM_SNAPSHOT
+/* First NVS ID of the spare range of the calling thread's instance */
+uint16_t softsim_storage_spare_base(void);
+/* Make the spare range the active profile, the old range the spare one */
+int softsim_storage_spare_commit(void);
+#endif
+
+/*
+ * Walk the valid allocation table entries of the partition, oldest first,
+ * deletions (len 0) included. A non-zero return of cb stops the walk, a
+ * negative one is returned. The NVS lock is held meanwhile: cb may use
+ * NVS itself but must not wait for another thread that does.
+ */
+int softsim_storage_ate_walk(softsim_storage_ate_cb cb, void *arg);
+
+/* NVS ID of a file named relative to the storage path, e.g. "3f00/2fe2" */
+uint16_t softsim_storage_file_id(uint16_t id_base, const char *name);
+
+/* nvs_read() of a record as stored */
+ssize_t softsim_storage_record_read(uint16_t id, void *buf, size_t len);
+
+/* File content: the record with its SQN delta applied */
+ssize_t softsim_storage_read(uint16_t id, void *buf, size_t len);
+
+/* nvs_write() of a file, as a delta for the SQN file */
+ssize_t softsim_storage_write(uint16_t id, const void *buf, size_t len);
+
+#ifdef CONFIG_SOFTSIM_SQN_RING
+/* Apply the delta of the SQN file to its record, rc as read, returns rc */
+ssize_t softsim_sqn_ring_apply(uint16_t id, void *buf, size_t len, ssize_t rc);
+/* Store the SQN file as a delta, -EAGAIN for the other files */
+ssize_t softsim_sqn_ring_write(uint16_t id, const void *buf, size_t len);
+/* The SQN file is deleted, drop its delta */
+void softsim_sqn_ring_drop(uint16_t id);
+/* The storage path changed, the SQN file IDs with it */
+void softsim_sqn_ring_reset(void);
+#else
+static inline ssize_t softsim_sqn_ring_apply(uint16_t id, void *buf, size_t len, ssize_t rc)
+{
+    (void)id;
+    (void)buf;
+    (void)len;
+    return rc;
+}
+
+static inline ssize_t softsim_sqn_ring_write(uint16_t id, const void *buf, size_t len)
+{
+    (void)id;
+    (void)buf;
+    (void)len;
+    return -EAGAIN;
+}
+
+static inline void softsim_sqn_ring_drop(uint16_t id)
+{
+    (void)id;
+}
+
+static inline void softsim_sqn_ring_reset(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_WEAR_STATS
+/* Account the flash bytes of a storage operation, rc as returned by NVS */
+void softsim_wear_note(enum softsim_storage_op op, uint16_t id, int rc);
+/* Persist the counters if they changed since the last save */
+int softsim_wear_sync(void);
+#else
+static inline void softsim_wear_note(enum softsim_storage_op op, uint16_t id, int rc)
+{
+    (void)op;
+    (void)id;
+    (void)rc;
+}
+
+static inline int softsim_wear_sync(void)
+{
+    return 0;
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_FS_POLICY
+/* RAM content of a volatile or write-back file, -ENOENT if flash is current */
+ssize_t softsim_fs_policy_get(uint16_t id, uint8_t *buf, size_t len);
+/* Keep a closed file in RAM per its policy, -EAGAIN to write it to flash now */
+int softsim_fs_policy_put(const char *path, uint16_t id, const uint8_t *buf, size_t len);
+/* Forget the RAM content of a file rewritten or deleted in flash */
+void softsim_fs_policy_drop(uint16_t id);
+/* Write the pending write-back files to flash */
+int softsim_fs_policy_flush(void);
+#else
+static inline ssize_t softsim_fs_policy_get(uint16_t id, uint8_t *buf, size_t len)
+{
+    (void)id;
+    (void)buf;
+    (void)len;
+    return -ENOENT;
+}
+
+static inline int softsim_fs_policy_put(const char *path, uint16_t id, const uint8_t *buf,
+                                        size_t len)
+{
+    (void)path;
+    (void)id;
+    (void)buf;
+    (void)len;
+    return -EAGAIN;
+}
+
+static inline void softsim_fs_policy_drop(uint16_t id)
+{
+    (void)id;
+}
+
+static inline int softsim_fs_policy_flush(void)
+{
+    return 0;
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_GC
+/* An APDU was processed, postpone background garbage collection */
+void softsim_storage_gc_activity(void);
+#else
+static inline void softsim_storage_gc_activity(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_FILE_CACHE
+ssize_t softsim_fs_cache_get(uint16_t nvs_id, uint8_t *buf, size_t len);
+void softsim_fs_cache_put(uint16_t nvs_id, const uint8_t *buf, size_t len);
+void softsim_fs_cache_invalidate(uint16_t nvs_id);
+void softsim_fs_cache_clear(void);
+#else
+static inline ssize_t softsim_fs_cache_get(uint16_t nvs_id, uint8_t *buf, size_t len)
+{
+    (void)nvs_id;
+    (void)buf;
+    (void)len;
+    return -ENOENT;
+}
+
+static inline void softsim_fs_cache_put(uint16_t nvs_id, const uint8_t *buf, size_t len)
+{
+    (void)nvs_id;
+    (void)buf;
+    (void)len;
+}
+
+static inline void softsim_fs_cache_invalidate(uint16_t nvs_id)
+{
+    (void)nvs_id;
+}
+
+static inline void softsim_fs_cache_clear(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_RSP_CACHE
+size_t softsim_rsp_cache_lookup(struct ss_context *ctx, uint8_t *rsp, size_t rsp_len,
+                                const uint8_t *req, size_t req_len);
+void softsim_rsp_cache_forward(struct ss_context *ctx);
+void softsim_rsp_cache_update(struct ss_context *ctx, const uint8_t *req, size_t req_len,
+                              const uint8_t *rsp, size_t rsp_len);
+void softsim_rsp_cache_reset(struct ss_context *ctx);
+void softsim_rsp_cache_invalidate(void);
+#else
+static inline size_t softsim_rsp_cache_lookup(struct ss_context *ctx, uint8_t *rsp,
+                                              size_t rsp_len, const uint8_t *req,
+                                              size_t req_len)
+{
+    (void)ctx;
+    (void)rsp;
+    (void)rsp_len;
+    (void)req;
+    (void)req_len;
+    return 0;
+}
+
+static inline void softsim_rsp_cache_forward(struct ss_context *ctx)
+{
+    (void)ctx;
+}
+
+static inline void softsim_rsp_cache_update(struct ss_context *ctx, const uint8_t *req,
+                                            size_t req_len, const uint8_t *rsp,
+                                            size_t rsp_len)
+{
+    (void)ctx;
+    (void)req;
+    (void)req_len;
+    (void)rsp;
+    (void)rsp_len;
+}
+
+static inline void softsim_rsp_cache_reset(struct ss_context *ctx)
+{
+    (void)ctx;
+}
+
+static inline void softsim_rsp_cache_invalidate(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_AES_KEY_CACHE
+void softsim_aes_key_cache_clear(void);
+#else
+static inline void softsim_aes_key_cache_clear(void)
+{
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_MULTI_INSTANCE
+/* Instance bound to the calling thread, 0 if none */
+unsigned int softsim_instance_current(void);
+unsigned int softsim_instance_of(struct ss_context *ctx);
+/*
+ * Bind the calling thread to the instance of ctx, *prev is what to restore.
+ * -ENOMEM when no binding is free: the thread must not touch storage.
+ */
+int softsim_instance_enter(struct ss_context *ctx, int *prev);
+void softsim_instance_leave(int prev);
+int softsim_instance_register(struct ss_context *ctx, unsigned int instance);
+void softsim_instance_unregister(struct ss_context *ctx);
+#else
+static inline unsigned int softsim_instance_current(void)
+{
+    return 0;
+}
+
+static inline unsigned int softsim_instance_of(struct ss_context *ctx)
+{
+    (void)ctx;
+    return 0;
+}
+
+static inline int softsim_instance_enter(struct ss_context *ctx, int *prev)
+{
+    (void)ctx;
+    *prev = -1;
+    return 0;
+}
+
+static inline void softsim_instance_leave(int prev)
+{
+    (void)prev;
+}
+
+static inline int softsim_instance_register(struct ss_context *ctx, unsigned int instance)
+{
+    (void)ctx;
+    (void)instance;
+    return 0;
+}
+
+static inline void softsim_instance_unregister(struct ss_context *ctx)
+{
+    (void)ctx;
+}
+#endif
+
+#ifdef CONFIG_SOFTSIM_TRACING
+#include <zephyr/tracing/tracing.h>
+/* Named events show up in the CTF/SystemView timeline; keep names short */
+#define SOFTSIM_TRACE(name, arg0, arg1) \
+    sys_trace_named_event(name, (uint32_t)(arg0), (uint32_t)(arg1))
+#else
+#define SOFTSIM_TRACE(name, arg0, arg1) \
+    do { (void)sizeof(arg0); (void)sizeof(arg1); } while (0)
+#endif
+
+/* Bracket every NVS call of the storage backend */
+static inline uint32_t softsim_storage_op_begin(enum softsim_storage_op op, uint16_t id)
+{
+    switch (op) {
+    case SOFTSIM_STORAGE_READ:
+        SOFTSIM_TRACE("ss_nvs_read_enter", id, 0);
+        break;
+    case SOFTSIM_STORAGE_WRITE:
+        SOFTSIM_TRACE("ss_nvs_write_enter", id, 0);
+        break;
+    default:
+        SOFTSIM_TRACE("ss_nvs_del_enter", id, 0);
+        break;
+    }
+
+    if (!IS_ENABLED(CONFIG_SOFTSIM_APDU_STATS)) {
+        return 0;
+    }
+    return k_cycle_get_32();
+}
+
+static inline void softsim_storage_op_end(enum softsim_storage_op op, uint16_t id,
+                                          uint32_t start, int rc)
+{
+    switch (op) {
+    case SOFTSIM_STORAGE_READ:
+        SOFTSIM_TRACE("ss_nvs_read_exit", id, rc);
+        break;
+    case SOFTSIM_STORAGE_WRITE:
+        SOFTSIM_TRACE("ss_nvs_write_exit", id, rc);
+        break;
+    default:
+        SOFTSIM_TRACE("ss_nvs_del_exit", id, rc);
+        break;
+    }
+
+    /* Cached APDU responses may reflect the old content */
+    if (op != SOFTSIM_STORAGE_READ) {
+        softsim_rsp_cache_invalidate();
+        softsim_wear_note(op, id, rc);
+    }
+
+    if (!IS_ENABLED(CONFIG_SOFTSIM_APDU_STATS)) {
+        return;
+    }
+    softsim_apdu_stats_storage(op, k_cycle_get_32() - start);
+}
+
+#endif /* SOFTSIM_INTERNAL_H_ */
@@ -0,0 +1,93 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Delta encoding of the MILENAGE SQN file
+ *
+ * Builds and applies the delta records of fs_sqn.c, kept apart from the
+ * storage so that the encoding can be tested on its own.
+ */
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <errno.h>
+#include <string.h>
+
+#include "sqn_delta.h"
+
+int sqn_delta_build(const uint8_t *base, const uint8_t *cur, size_t len,
+                    uint8_t *out, size_t max)
+{
+    size_t n = SQN_DELTA_HDR_LEN;
+    size_t i = 0;
+
+    if (max < SQN_DELTA_HDR_LEN) {
+        return -ENOSPC;
+    }
+
+    sys_put_le32(crc32_ieee(base, len), out);
+
+    while (i < len) {
+        size_t start, end;
+
+        if (base[i] == cur[i]) {
+            i++;
+            continue;
+        }
+
+        /* Runs separated by fewer equal bytes than an entry header merge */
+        start = i;
+        end = i + 1;
+        for (size_t j = end; j < len && j - start < UINT8_MAX; j++) {
+            if (base[j] != cur[j]) {
+                end = j + 1;
+            } else if (j - end >= SQN_DELTA_ENTRY_HDR) {
+                break;
+            }
+        }
+
+        if (n + SQN_DELTA_ENTRY_HDR + (end - start) > max) {
+            return -ENOSPC;
+        }
+        sys_put_le16(start, &out[n]);
+        out[n + 2] = end - start;
+        memcpy(&out[n + SQN_DELTA_ENTRY_HDR], &cur[start], end - start);
+        n += SQN_DELTA_ENTRY_HDR + (end - start);
+        i = end;
+    }
+
+    return n;
+}
+
+bool sqn_delta_walk(const uint8_t *delta, size_t dlen, uint8_t *buf, size_t len,
+                    bool apply)
+{
+    size_t n = SQN_DELTA_HDR_LEN;
+
+    while (n < dlen) {
+        uint16_t off;
+        uint8_t run;
+
+        if (n + SQN_DELTA_ENTRY_HDR > dlen) {
+            return false;
+        }
+        off = sys_get_le16(&delta[n]);
+        run = delta[n + 2];
+        n += SQN_DELTA_ENTRY_HDR;
+        if (run == 0 || n + run > dlen || off + run > len) {
+            return false;
+        }
+        if (apply) {
+            memcpy(&buf[off], &delta[n], run);
+        }
+        n += run;
+    }
+
+    return true;
+}
+
+uint32_t sqn_delta_base_crc(const uint8_t *delta)
+{
+    return sys_get_le32(delta);
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Delta encoding of the MILENAGE SQN file
+ *
+ * Pure buffer code, no storage access, used by fs_sqn.c. Delta record,
+ * little-endian:
+ *   crc32_ieee of the base it applies to (u32)
+ *   { offset (u16), length (u8), bytes } ...
+ */
+
+#ifndef SOFTSIM_SQN_DELTA_H_
+#define SOFTSIM_SQN_DELTA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SQN_DELTA_HDR_LEN   4
+#define SQN_DELTA_ENTRY_HDR 3
+
+/**
+ * @brief Build the delta turning @p base into @p cur.
+ *
+ * Runs of changed bytes separated by fewer unchanged bytes than an entry
+ * header are merged into one entry.
+ *
+ * @return Delta length, SQN_DELTA_HDR_LEN if @p cur equals @p base,
+ *         -ENOSPC if the delta does not fit in @p max bytes.
+ */
+int sqn_delta_build(const uint8_t *base, const uint8_t *cur, size_t len,
+                    uint8_t *out, size_t max);
+
+/**
+ * @brief Check a delta against a @p len byte buffer, then patch it.
+ *
+ * The checksum of the base is not checked here.
+ *
+ * @param apply  Patch @p buf, otherwise only check the entries.
+ *
+ * @return false if an entry is malformed or falls outside @p buf.
+ */
+bool sqn_delta_walk(const uint8_t *delta, size_t dlen, uint8_t *buf, size_t len,
+                    bool apply);
+
+/* Checksum of the base the delta applies to */
+uint32_t sqn_delta_base_crc(const uint8_t *delta);
+
+#endif /* SOFTSIM_SQN_DELTA_H_ */
@@ -0,0 +1,193 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Zephyr transaction layer for onomondo-uicc
+ *
+ * Wraps ss_transact() so that the optional diagnostics can observe every
+ * APDU without the application having to wire them up, and so that the
+ * response cache can answer repeated read-only commands.
+ *
+ * Commands of feature groups disabled in Kconfig (CAT, OTA) are rejected
+ * here, before they reach the library command dispatch.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <onomondo/softsim/softsim.h>
+#include <softsim/transact.h>
+
+#include "softsim_internal.h"
+
+LOG_MODULE_REGISTER(softsim_apdu, CONFIG_SOFTSIM_LOG_LEVEL);
+
+/* ISO/IEC 7816-3: an ATR is at most 33 bytes */
+#define ATR_MAX_LEN 33
+
+#define INS_TERMINAL_PROFILE  0x10
+#define INS_FETCH             0x12
+#define INS_TERMINAL_RESPONSE 0x14
+#define INS_ENVELOPE          0xc2
+
+/* ETSI TS 101 220: SMS-PP download BER-TLV tag, carries OTA packets */
+#define TAG_SMS_PP_DOWNLOAD   0xd1
+
+static uint8_t atr_buf[ATR_MAX_LEN];
+static size_t atr_len;
+static K_MUTEX_DEFINE(atr_lock);
+
+/* Status word answering a command of a disabled feature, 0 if enabled */
+static uint16_t feature_disabled_sw(const uint8_t *req, size_t req_len)
+{
+    switch (softsim_apdu_ins(req, req_len)) {
+    case INS_TERMINAL_PROFILE:
+    case INS_FETCH:
+    case INS_TERMINAL_RESPONSE:
+        return IS_ENABLED(CONFIG_SOFTSIM_CAT) ? 0 : 0x6d00;
+    case INS_ENVELOPE:
+        if (!IS_ENABLED(CONFIG_SOFTSIM_CAT)) {
+            return 0x6d00;
+        }
+        if (!IS_ENABLED(CONFIG_SOFTSIM_OTA) && req_len > 5 && req[5] == TAG_SMS_PP_DOWNLOAD) {
+            return 0x6a81;
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+size_t softsim_transact(struct ss_context *ctx, uint8_t *rsp, size_t rsp_len,
+                        uint8_t *req, size_t *req_len)
+{
+    struct softsim_apdu_info info;
+    uint32_t start;
+    uint16_t sw;
+    size_t len;
+    int prev;
+
+    info.cmd = req;
+    info.cmd_len = *req_len;
+
+    SOFTSIM_TRACE("ss_apdu_start",
+                  (*req_len >= 4) ? sys_get_be32(req) : 0, *req_len);
+
+    /* Unbound, the storage would be the one of instance 0 */
+    if (softsim_instance_enter(ctx, &prev)) {
+        if (rsp_len < 2) {
+            return 0;
+        }
+        sys_put_be16(0x6f00, rsp);
+        return 2;
+    }
+    softsim_apdu_stats_begin();
+    softsim_arena_begin();
+    softsim_alloc_trace_apdu_begin(softsim_apdu_ins(req, *req_len));
+    start = k_cycle_get_32();
+    sw = feature_disabled_sw(req, *req_len);
+    if (sw && rsp_len >= 2) {
+        sys_put_be16(sw, rsp);
+        len = 2;
+    } else {
+        len = softsim_rsp_cache_lookup(ctx, rsp, rsp_len, req, *req_len);
+        if (len == 0) {
+            softsim_rsp_cache_forward(ctx);
+            len = ss_transact(ctx, rsp, rsp_len, req, req_len);
+            softsim_rsp_cache_update(ctx, req, info.cmd_len, rsp, len);
+        }
+    }
+    /* Without CAT the modem must not be asked to FETCH */
+    if (!IS_ENABLED(CONFIG_SOFTSIM_CAT) && len >= 2 && rsp[len - 2] == 0x91) {
+        sys_put_be16(0x9000, &rsp[len - 2]);
+    }
+    info.cycles = k_cycle_get_32() - start;
+    softsim_storage_gc_activity();
+    softsim_alloc_trace_apdu_end();
+    softsim_arena_end();
+    softsim_instance_leave(prev);
+
+    info.rsp = rsp;
+    info.rsp_len = len;
+    info.sw = (len >= 2) ? ((uint16_t)rsp[len - 2] << 8) | rsp[len - 1] : 0;
+
+    SOFTSIM_TRACE("ss_apdu_end", info.sw, len);
+
+    softsim_apdu_trace_record(&info);
+    softsim_apdu_pcap_record(&info);
+    softsim_apdu_stats_record(&info);
+
+    return len;
+}
+
+size_t softsim_atr(struct ss_context *ctx, const uint8_t **atr)
+{
+    k_mutex_lock(&atr_lock, K_FOREVER);
+
+    if (atr_len == 0 && ctx) {
+        int prev;
+
+        if (softsim_instance_enter(ctx, &prev) == 0) {
+            atr_len = ss_atr(ctx, atr_buf, sizeof(atr_buf));
+            softsim_instance_leave(prev);
+            LOG_DBG("ATR cached (%zu bytes)", atr_len);
+        }
+    }
+
+    k_mutex_unlock(&atr_lock);
+
+    *atr = atr_buf;
+    return atr_len;
+}
+
+void softsim_warm_reset(struct ss_context *ctx)
+{
+    int prev;
+
+    if (softsim_instance_enter(ctx, &prev)) {
+        return;
+    }
+
+    SOFTSIM_TRACE("ss_warm_reset", 0, 0);
+    ss_reset(ctx);
+    softsim_rsp_cache_reset(ctx);
+
+    softsim_instance_leave(prev);
+}
+
+struct ss_context *softsim_cold_reset(struct ss_context *ctx)
+{
+    unsigned int instance = softsim_instance_of(ctx);
+    int prev;
+
+    /* The context stays as is, it is not freed without its instance */
+    if (softsim_instance_enter(ctx, &prev)) {
+        return ctx;
+    }
+
+    SOFTSIM_TRACE("ss_cold_reset", instance, 0);
+
+    if (ctx) {
+        softsim_rsp_cache_reset(ctx);
+        ss_free_ctx(ctx);
+        softsim_instance_unregister(ctx);
+    }
+    softsim_fs_cache_clear();
+    softsim_rsp_cache_invalidate();
+    softsim_aes_key_cache_clear();
+
+    ctx = ss_new_ctx();
+    if (!ctx) {
+        LOG_ERR("cold reset: failed to allocate context");
+    } else if (softsim_instance_register(ctx, instance)) {
+        LOG_ERR("cold reset: failed to register context");
+        ss_free_ctx(ctx);
+        ctx = NULL;
+    }
+
+    softsim_instance_leave(prev);
+
+    return ctx;
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: AGPL-3.0-only
+#
+# Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+#
+# Generate the AES test vectors of tests/crypto/aes_ct with OpenSSL
+#
+# Keys and plaintexts come from a seeded PRNG, so the output only changes
+# with the seed or the counts. Each block is encrypted by `openssl enc`
+# in ECB mode without padding.
+
+import argparse
+import random
+import subprocess
+import sys
+
+COUNTS = {16: 32, 24: 4, 32: 4}
+
+
+def encrypt(key, block):
+    out = subprocess.run(
+        ['openssl', 'enc', '-aes-%d-ecb' % (len(key) * 8), '-nopad', '-K', key.hex()],
+        input=block, stdout=subprocess.PIPE, check=True)
+    return out.stdout
+
+
+def c_bytes(data):
+    return '{ ' + ', '.join('0x%02x' % b for b in data) + ' }'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-s', '--seed', type=int, default=0x5053494d)
+    parser.add_argument('-o', '--output', default='-')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    lines = [
+        '/* Generated by gen_vectors.py --seed 0x%x, do not edit */' % args.seed,
+        '',
+    ]
+
+    for key_len, count in COUNTS.items():
+        lines.append('static const struct aes_vector aes%d_vectors[] = {' % (key_len * 8))
+        for _ in range(count):
+            key = bytes(rng.getrandbits(8) for _ in range(key_len))
+            plain = bytes(rng.getrandbits(8) for _ in range(16))
+            lines.append('    {')
+            lines.append('        .key = %s,' % c_bytes(key))
+            lines.append('        .plain = %s,' % c_bytes(plain))
+            lines.append('        .crypt = %s,' % c_bytes(encrypt(key, plain)))
+            lines.append('    },')
+        lines.append('};')
+        lines.append('')
+
+    text = '\n'.join(lines)
+    if args.output == '-':
+        sys.stdout.write(text)
+    else:
+        with open(args.output, 'w') as f:
+            f.write(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Constant-time AES backend against OpenSSL
+ *
+ * src/vectors.h is produced by gen_vectors.py from `openssl enc`. The
+ * AES-128 blocks go through the bitsliced kernel, the AES-192/256 ones
+ * through the library table code it falls back to.
+ */
+
+#include <zephyr/ztest.h>
+#include <stdint.h>
+#include <string.h>
+
+/* crypto/aes.h of the UICC library */
+void *aes_encrypt_init(const uint8_t *key, size_t len);
+int aes_encrypt(void *ctx, const uint8_t *plain, uint8_t *crypt);
+void aes_encrypt_deinit(void *ctx);
+int aes_128_encrypt_block(const uint8_t *key, const uint8_t *in, uint8_t *out);
+
+struct aes_vector {
+    uint8_t key[32];
+    uint8_t plain[16];
+    uint8_t crypt[16];
+};
+
+#include "vectors.h"
+
+static void check_vectors(const struct aes_vector *v, size_t count, size_t key_len)
+{
+    uint8_t out[16];
+
+    for (size_t i = 0; i < count; i++) {
+        void *ctx = aes_encrypt_init(v[i].key, key_len);
+
+        zassert_not_null(ctx, "AES-%zu vector %zu: init failed", key_len * 8, i);
+        zassert_ok(aes_encrypt(ctx, v[i].plain, out));
+        aes_encrypt_deinit(ctx);
+        zassert_mem_equal(out, v[i].crypt, sizeof(out), "AES-%zu vector %zu", key_len * 8, i);
+    }
+}
+
+ZTEST(aes_ct, test_fips197)
+{
+    static const uint8_t key[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    static const uint8_t plain[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    static const uint8_t crypt[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+    };
+    uint8_t out[16];
+    void *ctx = aes_encrypt_init(key, sizeof(key));
+
+    zassert_not_null(ctx);
+    zassert_ok(aes_encrypt(ctx, plain, out));
+    aes_encrypt_deinit(ctx);
+    zassert_mem_equal(out, crypt, sizeof(out));
+}
+
+ZTEST(aes_ct, test_aes128_openssl)
+{
+    check_vectors(aes128_vectors, ARRAY_SIZE(aes128_vectors), 16);
+}
+
+ZTEST(aes_ct, test_aes192_openssl)
+{
+    check_vectors(aes192_vectors, ARRAY_SIZE(aes192_vectors), 24);
+}
+
+ZTEST(aes_ct, test_aes256_openssl)
+{
+    check_vectors(aes256_vectors, ARRAY_SIZE(aes256_vectors), 32);
+}
+
+ZTEST(aes_ct, test_bad_key_len)
+{
+    static const uint8_t key[20];
+
+    zassert_is_null(aes_encrypt_init(key, sizeof(key)));
+}
+
+/* MILENAGE entry point: the key cache must follow a change of key */
+ZTEST(aes_ct, test_block_key_change)
+{
+    uint8_t out[16];
+
+    for (size_t i = 0; i < ARRAY_SIZE(aes128_vectors); i++) {
+        const struct aes_vector *v = &aes128_vectors[i % 2 ? i : 0];
+
+        zassert_ok(aes_128_encrypt_block(v->key, v->plain, out));
+        zassert_mem_equal(out, v->crypt, sizeof(out), "vector %zu", i);
+    }
+}
+
+ZTEST_SUITE(aes_ct, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,210 @@
+/* Generated by gen_vectors.py --seed 0x5053494d, do not edit */
+
+static const struct aes_vector aes128_vectors[] = {
+    {
+        .key = { 0xb9, 0x9e, 0x79, 0x2b, 0x1f, 0x67, 0xcc, 0xa2, 0x63, 0xaf, 0x4b, 0x3b, 0xfc, 0x9c, 0xa4, 0x61 },
+        .plain = { 0x94, 0x9c, 0xde, 0x54, 0x5b, 0x1b, 0xc8, 0x58, 0x02, 0x91, 0x2b, 0x7b, 0x8d, 0x8d, 0x79, 0x46 },
+        .crypt = { 0xd8, 0xa3, 0x8e, 0x42, 0x37, 0x02, 0xda, 0xb5, 0x41, 0x34, 0xea, 0x51, 0x45, 0x95, 0x34, 0x0a },
+    },
+    {
+        .key = { 0x4f, 0x08, 0x31, 0xd5, 0x0f, 0xc6, 0xfc, 0x91, 0x94, 0x93, 0xdd, 0x84, 0x41, 0xcd, 0xcc, 0xab },
+        .plain = { 0x45, 0xf4, 0x70, 0x72, 0xcb, 0x6a, 0x8f, 0x92, 0xbc, 0x83, 0x24, 0xd3, 0xd1, 0xfe, 0x87, 0x82 },
+        .crypt = { 0x98, 0x38, 0x4e, 0x04, 0xd5, 0x4a, 0x1c, 0x8d, 0xc6, 0xee, 0x89, 0x66, 0x0d, 0xef, 0x8b, 0xbe },
+    },
+    {
+        .key = { 0xf6, 0xef, 0x8d, 0xfe, 0xf0, 0x0f, 0x5f, 0xc2, 0x91, 0x3f, 0xbd, 0x6c, 0x4c, 0x35, 0x9d, 0x55 },
+        .plain = { 0xa4, 0x02, 0x4c, 0x26, 0xd5, 0xf0, 0xf4, 0x7e, 0x82, 0x55, 0x3b, 0x4c, 0x94, 0x65, 0x4b, 0xae },
+        .crypt = { 0x11, 0x90, 0xdc, 0xf0, 0x7f, 0x58, 0x5d, 0x97, 0x54, 0xa1, 0x63, 0xd0, 0x67, 0xdd, 0x35, 0x6f },
+    },
+    {
+        .key = { 0xea, 0x54, 0xd7, 0x6f, 0xf3, 0x96, 0x00, 0x5b, 0xc7, 0x67, 0x81, 0x82, 0x1b, 0x1f, 0x59, 0xa3 },
+        .plain = { 0xaf, 0xd5, 0x14, 0x2e, 0xe8, 0x76, 0xec, 0x7c, 0x74, 0x07, 0x39, 0xb5, 0xb4, 0x3c, 0xe2, 0x48 },
+        .crypt = { 0x75, 0x2e, 0xaa, 0x9e, 0xe5, 0xa6, 0x58, 0x71, 0xbf, 0x0b, 0xc2, 0x44, 0x44, 0xc6, 0xcd, 0xd1 },
+    },
+    {
+        .key = { 0x3b, 0x8f, 0xed, 0xc6, 0x2f, 0x58, 0xed, 0x4a, 0x84, 0xdc, 0x25, 0xb2, 0x67, 0x5d, 0x75, 0xaf },
+        .plain = { 0x30, 0xf4, 0x4f, 0xe1, 0xd9, 0xf0, 0xe2, 0x3b, 0xbb, 0x98, 0xd1, 0x4b, 0x01, 0x50, 0xc1, 0x40 },
+        .crypt = { 0xab, 0x37, 0x77, 0x33, 0x64, 0xcc, 0x48, 0xaa, 0xb4, 0x1d, 0x1f, 0x19, 0x40, 0xce, 0x6d, 0x59 },
+    },
+    {
+        .key = { 0xa5, 0xfd, 0x8f, 0xa9, 0x91, 0xa3, 0x56, 0xa3, 0xb7, 0x7a, 0x57, 0xc6, 0x13, 0x44, 0xb9, 0x05 },
+        .plain = { 0x04, 0x30, 0x5f, 0x8c, 0x2f, 0x47, 0x2f, 0x96, 0x12, 0x6c, 0xea, 0xce, 0x5f, 0xda, 0xb5, 0xb4 },
+        .crypt = { 0x46, 0x86, 0x55, 0xb6, 0xb3, 0x85, 0xef, 0xe0, 0xa5, 0xe9, 0x5d, 0x1b, 0xe3, 0x51, 0xf2, 0xb5 },
+    },
+    {
+        .key = { 0x80, 0xb3, 0x7e, 0x1d, 0x88, 0x99, 0x72, 0x76, 0x3a, 0xe0, 0x85, 0x19, 0x7e, 0xef, 0x13, 0x08 },
+        .plain = { 0x9a, 0x5f, 0xdc, 0xbe, 0x23, 0xbb, 0xf3, 0x54, 0x26, 0x61, 0xb8, 0xd0, 0xf2, 0x2b, 0xdf, 0x2d },
+        .crypt = { 0xc1, 0x26, 0x98, 0xaf, 0xf4, 0xf4, 0x4e, 0x11, 0xbc, 0x18, 0x62, 0x7b, 0x5b, 0x18, 0xaf, 0x35 },
+    },
+    {
+        .key = { 0x84, 0xe0, 0x2d, 0x24, 0x94, 0x78, 0x29, 0x7a, 0x34, 0x05, 0x60, 0x13, 0x2f, 0xaf, 0xb5, 0xd0 },
+        .plain = { 0x13, 0xb5, 0xc3, 0xe2, 0x2c, 0x56, 0xf9, 0x0b, 0xb0, 0xd4, 0x79, 0x6f, 0x2d, 0x6b, 0xd6, 0xc2 },
+        .crypt = { 0xf5, 0x1e, 0x8f, 0x24, 0x12, 0x72, 0xbf, 0x10, 0x05, 0xde, 0xf1, 0xe3, 0x89, 0x9a, 0xa7, 0xfc },
+    },
+    {
+        .key = { 0xd7, 0xe5, 0x4c, 0xf8, 0xb3, 0x3b, 0x95, 0xb4, 0x62, 0x71, 0x9c, 0x9f, 0x59, 0x87, 0xb4, 0x2d },
+        .plain = { 0xe3, 0x36, 0x7e, 0xf4, 0xee, 0x79, 0xe1, 0xd1, 0xfd, 0x9c, 0x11, 0xdd, 0x76, 0x21, 0xd5, 0x98 },
+        .crypt = { 0x51, 0x04, 0x10, 0x74, 0xc4, 0x32, 0x80, 0x4d, 0x40, 0xac, 0x1f, 0x90, 0xaa, 0x89, 0xf4, 0xa0 },
+    },
+    {
+        .key = { 0xa6, 0xc0, 0x4c, 0xa0, 0x90, 0x1b, 0x6b, 0x7c, 0x15, 0x21, 0x21, 0x09, 0x42, 0xeb, 0x5b, 0x3c },
+        .plain = { 0xb4, 0x93, 0x16, 0x31, 0xf6, 0xb1, 0x60, 0x88, 0xae, 0x43, 0x45, 0x10, 0x73, 0xaa, 0x6a, 0x01 },
+        .crypt = { 0x3f, 0x61, 0xdf, 0x90, 0x95, 0x66, 0x0d, 0xa6, 0x9a, 0x63, 0xa7, 0x8d, 0xf4, 0x7b, 0x6f, 0xe9 },
+    },
+    {
+        .key = { 0x0c, 0x78, 0xa8, 0xcd, 0xa9, 0x99, 0x6c, 0xd3, 0x75, 0x17, 0x31, 0x84, 0x14, 0x7e, 0x96, 0xf6 },
+        .plain = { 0xb4, 0x48, 0x7c, 0xef, 0xc9, 0x1f, 0x45, 0xea, 0x41, 0xeb, 0xd1, 0xf8, 0x9f, 0x84, 0xfc, 0x84 },
+        .crypt = { 0x13, 0xa9, 0x35, 0x3b, 0x19, 0x6f, 0x81, 0xf2, 0xae, 0xfb, 0x48, 0x8b, 0x9f, 0x33, 0xb2, 0x4e },
+    },
+    {
+        .key = { 0x09, 0x66, 0x1e, 0x8f, 0xad, 0x59, 0x26, 0xda, 0x81, 0x75, 0xe0, 0x19, 0xa5, 0xdf, 0x89, 0xdf },
+        .plain = { 0x99, 0x19, 0x63, 0xd3, 0x4c, 0x35, 0xd8, 0xdc, 0x46, 0x7e, 0x56, 0x36, 0xc9, 0x7e, 0x92, 0x5f },
+        .crypt = { 0xc5, 0x07, 0x8d, 0x9f, 0x3e, 0xce, 0x55, 0x41, 0xe7, 0x14, 0x1e, 0x7b, 0xdc, 0x83, 0x19, 0xb8 },
+    },
+    {
+        .key = { 0x88, 0x55, 0xc9, 0x65, 0x65, 0x34, 0xbd, 0xf7, 0xf9, 0xd4, 0x2f, 0xa7, 0x13, 0x49, 0x61, 0xdb },
+        .plain = { 0x90, 0x84, 0x6f, 0x7e, 0x8f, 0xd3, 0xa9, 0x7a, 0x32, 0x63, 0x82, 0x4b, 0x75, 0x0d, 0x11, 0x09 },
+        .crypt = { 0xc3, 0x81, 0x17, 0x20, 0x62, 0x9b, 0x5d, 0xa3, 0x0a, 0xf5, 0x30, 0x92, 0x9f, 0x32, 0x1a, 0x35 },
+    },
+    {
+        .key = { 0xe9, 0x5d, 0x02, 0x25, 0xe2, 0x06, 0x5b, 0xa3, 0x6d, 0xfd, 0x0d, 0x33, 0x8d, 0xcf, 0x82, 0x12 },
+        .plain = { 0xcb, 0x4b, 0xac, 0xfa, 0x07, 0xcd, 0x30, 0x38, 0x6c, 0xa0, 0x09, 0xdf, 0x47, 0x54, 0x3a, 0x9a },
+        .crypt = { 0xdd, 0xb5, 0xf9, 0x0b, 0xbc, 0x42, 0xd8, 0xdd, 0x33, 0xb9, 0xcb, 0x1e, 0x6c, 0x62, 0xe8, 0xf8 },
+    },
+    {
+        .key = { 0xf7, 0xf8, 0xa5, 0x2c, 0xc4, 0x69, 0xba, 0xcf, 0x2e, 0x91, 0xd9, 0x19, 0xda, 0x65, 0x9a, 0x53 },
+        .plain = { 0x1e, 0x7a, 0x20, 0xa8, 0xc3, 0xc5, 0xb6, 0xba, 0x37, 0xde, 0x31, 0xfb, 0x97, 0x2f, 0xc8, 0x64 },
+        .crypt = { 0x32, 0x14, 0x6d, 0x32, 0x10, 0xfe, 0xfc, 0x6e, 0x30, 0x9d, 0xf3, 0xe1, 0x5f, 0xf3, 0x6e, 0xe2 },
+    },
+    {
+        .key = { 0xff, 0xdf, 0xbb, 0x7f, 0x5b, 0xbc, 0x38, 0xbf, 0xe4, 0xc3, 0xe2, 0xcf, 0x55, 0x2e, 0x7c, 0x8c },
+        .plain = { 0xcf, 0xa4, 0xd5, 0x4d, 0xfa, 0x6b, 0x62, 0xd5, 0x1c, 0x4b, 0xff, 0x21, 0x9d, 0xf5, 0x29, 0xf3 },
+        .crypt = { 0xfb, 0xf5, 0xf8, 0x74, 0x36, 0xa6, 0xe6, 0x9f, 0xa0, 0x3a, 0xb7, 0xc4, 0xd0, 0x11, 0x83, 0x46 },
+    },
+    {
+        .key = { 0xe7, 0x0e, 0x28, 0x90, 0xe5, 0xb7, 0x3c, 0x30, 0x92, 0xe3, 0x70, 0x71, 0x83, 0xed, 0xd8, 0xf1 },
+        .plain = { 0x8b, 0x22, 0xed, 0xfb, 0x26, 0x6b, 0x39, 0x65, 0xad, 0xcf, 0xf3, 0x59, 0x62, 0x97, 0xa5, 0x36 },
+        .crypt = { 0x2f, 0x05, 0x13, 0xd5, 0xd0, 0x30, 0xee, 0xab, 0x36, 0x13, 0x08, 0xc1, 0xc0, 0xc7, 0x15, 0xea },
+    },
+    {
+        .key = { 0xc2, 0xc3, 0xf0, 0x56, 0x9d, 0xe3, 0x49, 0x30, 0x92, 0x48, 0x1c, 0x6e, 0x42, 0x03, 0x10, 0x4b },
+        .plain = { 0xad, 0xe7, 0xde, 0x22, 0x95, 0x37, 0xcb, 0x30, 0x30, 0x23, 0x38, 0x1a, 0xfa, 0x18, 0x54, 0xdd },
+        .crypt = { 0x79, 0xfa, 0x69, 0x22, 0xad, 0xba, 0x12, 0x6d, 0xea, 0x7c, 0xc4, 0xa0, 0x52, 0x19, 0x54, 0xf1 },
+    },
+    {
+        .key = { 0x4a, 0x65, 0x6f, 0x98, 0xb2, 0x09, 0xbf, 0xf8, 0xea, 0x81, 0xea, 0x95, 0x2f, 0xdf, 0xdf, 0x21 },
+        .plain = { 0xf1, 0x2d, 0x2f, 0x97, 0x76, 0xac, 0x0b, 0x33, 0x0e, 0xe2, 0xee, 0xdd, 0x49, 0x56, 0x7e, 0xd8 },
+        .crypt = { 0xa2, 0x0e, 0xb5, 0xba, 0x16, 0x50, 0x7f, 0xde, 0x44, 0x31, 0x27, 0x8e, 0xb0, 0x4d, 0xde, 0x8a },
+    },
+    {
+        .key = { 0x54, 0x36, 0xcb, 0x99, 0x86, 0x94, 0x53, 0xff, 0xf3, 0x59, 0xcb, 0x83, 0x41, 0xb9, 0x15, 0x10 },
+        .plain = { 0x74, 0x36, 0x66, 0x42, 0x6b, 0xc9, 0xdb, 0x82, 0xed, 0x91, 0xd1, 0xa2, 0x2c, 0xc0, 0x0a, 0x20 },
+        .crypt = { 0x47, 0xb0, 0x41, 0xed, 0xbc, 0x6a, 0x48, 0x93, 0x0c, 0x7c, 0x45, 0x1b, 0x10, 0x1e, 0x06, 0xec },
+    },
+    {
+        .key = { 0xee, 0x43, 0x5f, 0xf6, 0x67, 0x22, 0xe0, 0xe0, 0x44, 0x3c, 0x52, 0x99, 0xb3, 0x64, 0x89, 0xb5 },
+        .plain = { 0xbc, 0xbd, 0xe4, 0x55, 0x82, 0xb1, 0xe1, 0x35, 0xc7, 0x86, 0x44, 0xf6, 0xcc, 0x44, 0x13, 0x81 },
+        .crypt = { 0x1b, 0x03, 0x43, 0x86, 0x30, 0x7c, 0xa8, 0x3d, 0xd9, 0xbe, 0x7c, 0xaa, 0x69, 0x58, 0x37, 0x6f },
+    },
+    {
+        .key = { 0x1d, 0xd6, 0x60, 0x63, 0x48, 0xee, 0x66, 0x03, 0x67, 0x61, 0x86, 0xed, 0x75, 0xc7, 0xa3, 0x8f },
+        .plain = { 0x9d, 0xb8, 0xcc, 0x04, 0xd4, 0xc6, 0xf1, 0x21, 0x5f, 0x27, 0x0b, 0xb2, 0x93, 0x95, 0xc8, 0x7c },
+        .crypt = { 0x74, 0x87, 0x13, 0x2d, 0x9a, 0x2a, 0xf6, 0x7a, 0xfc, 0x71, 0xee, 0x19, 0x8b, 0xfe, 0xc5, 0x7c },
+    },
+    {
+        .key = { 0x73, 0xea, 0x9e, 0x88, 0x20, 0xcb, 0xfb, 0x9c, 0x5a, 0x3f, 0xcf, 0xc1, 0x28, 0x1e, 0xc4, 0x2b },
+        .plain = { 0xef, 0x44, 0x23, 0x52, 0xff, 0xe8, 0xbe, 0x71, 0x1c, 0xd5, 0xac, 0x11, 0xa8, 0xcd, 0x64, 0xb4 },
+        .crypt = { 0x82, 0x66, 0x6d, 0x45, 0xc2, 0x32, 0x64, 0xd5, 0xb3, 0x28, 0x4c, 0x32, 0x78, 0xf5, 0x91, 0x71 },
+    },
+    {
+        .key = { 0x98, 0x39, 0x9b, 0x9a, 0xd4, 0x7c, 0xc6, 0xb0, 0x6b, 0x78, 0xd1, 0xfe, 0x81, 0xad, 0x3e, 0xc2 },
+        .plain = { 0xc1, 0xa5, 0x96, 0xaa, 0x6b, 0x42, 0x6e, 0x61, 0xc6, 0x39, 0x92, 0xca, 0xb4, 0xfe, 0xda, 0x25 },
+        .crypt = { 0x6a, 0xad, 0x64, 0x55, 0x82, 0xe1, 0x32, 0x1d, 0x64, 0xc2, 0xaa, 0x74, 0x4a, 0x71, 0x82, 0xd1 },
+    },
+    {
+        .key = { 0xf2, 0x86, 0x1b, 0x69, 0x96, 0x2f, 0xb9, 0x96, 0x3c, 0xda, 0x35, 0xaa, 0x0a, 0xd9, 0x4b, 0xa7 },
+        .plain = { 0x58, 0xd5, 0x9c, 0xb3, 0x18, 0x30, 0x4c, 0xdc, 0xef, 0x09, 0xe2, 0x66, 0xbc, 0xce, 0x3f, 0xc6 },
+        .crypt = { 0x64, 0x98, 0x2d, 0x8b, 0x9b, 0x62, 0x76, 0x06, 0xe9, 0x65, 0xa8, 0xf1, 0x86, 0x49, 0x46, 0xee },
+    },
+    {
+        .key = { 0x75, 0xba, 0xef, 0xc0, 0x9d, 0xab, 0xbe, 0xd8, 0x9a, 0x89, 0xb9, 0xcf, 0xf8, 0x0f, 0x20, 0x3c },
+        .plain = { 0x73, 0xe4, 0x2d, 0x59, 0x3a, 0xd6, 0x31, 0x3e, 0x53, 0x9a, 0x95, 0xf3, 0x4e, 0xfc, 0xf7, 0xa1 },
+        .crypt = { 0xd4, 0xd8, 0x6d, 0xc7, 0x96, 0xfc, 0x26, 0x0b, 0x9b, 0x50, 0xec, 0x08, 0x80, 0xf9, 0x3b, 0x4d },
+    },
+    {
+        .key = { 0xcb, 0x3e, 0x1b, 0xa5, 0x9b, 0x0d, 0x4b, 0x62, 0x62, 0x6c, 0x9d, 0xbc, 0xd8, 0x9e, 0xc7, 0x63 },
+        .plain = { 0xe4, 0xde, 0xa0, 0x36, 0x0f, 0x63, 0x69, 0x03, 0x22, 0xb2, 0x60, 0x27, 0x16, 0xb8, 0xfa, 0x8d },
+        .crypt = { 0x8c, 0x54, 0xef, 0xc4, 0xc2, 0xce, 0xfc, 0xd8, 0x2b, 0x84, 0x2d, 0x7c, 0x83, 0xe7, 0xc3, 0x62 },
+    },
+    {
+        .key = { 0x25, 0x5c, 0x44, 0x95, 0xc0, 0xe1, 0x82, 0x28, 0x82, 0x94, 0x54, 0xb1, 0x42, 0x53, 0x5f, 0xe8 },
+        .plain = { 0x41, 0x59, 0xec, 0xb0, 0xd7, 0x1e, 0xab, 0xa3, 0x52, 0x9e, 0xda, 0xe6, 0x6d, 0xfe, 0x33, 0x72 },
+        .crypt = { 0xf1, 0xf6, 0x9f, 0xea, 0x85, 0xb3, 0x7c, 0x88, 0xd2, 0x86, 0x06, 0xd3, 0x93, 0x92, 0xe1, 0xf2 },
+    },
+    {
+        .key = { 0x6d, 0xea, 0x5e, 0x3c, 0xfb, 0x81, 0x22, 0xae, 0x37, 0x21, 0x54, 0xa2, 0xe0, 0x9e, 0x28, 0xfb },
+        .plain = { 0x4a, 0x63, 0x93, 0x1f, 0x62, 0x82, 0x60, 0xa7, 0x6b, 0xd0, 0x28, 0x04, 0xb8, 0xc5, 0xd4, 0x06 },
+        .crypt = { 0x33, 0x70, 0xe1, 0x45, 0x9a, 0x2e, 0x84, 0x9e, 0xde, 0x0b, 0x75, 0x70, 0x58, 0x0b, 0xf4, 0x78 },
+    },
+    {
+        .key = { 0x98, 0x63, 0x63, 0xe8, 0x13, 0x44, 0x2b, 0x13, 0x2c, 0xaa, 0x7d, 0x1e, 0x9e, 0xfa, 0xcc, 0xe5 },
+        .plain = { 0xbc, 0xd9, 0x50, 0xb1, 0xcc, 0x93, 0xb3, 0xcb, 0x01, 0xd4, 0x3f, 0xcc, 0x31, 0x04, 0x78, 0xb8 },
+        .crypt = { 0x8f, 0xa1, 0xbf, 0xf8, 0x2a, 0xe8, 0x9e, 0x4f, 0x90, 0x35, 0x0e, 0x10, 0x6f, 0xf1, 0xd8, 0xf3 },
+    },
+    {
+        .key = { 0xcd, 0xca, 0xb8, 0x6f, 0x5f, 0x12, 0x9f, 0x4d, 0xb7, 0x16, 0x26, 0x06, 0xf2, 0xbb, 0xae, 0x2f },
+        .plain = { 0x33, 0xa1, 0x79, 0x2a, 0x79, 0x8e, 0xdc, 0x4f, 0x54, 0x38, 0x68, 0xa4, 0xff, 0x95, 0xdf, 0x87 },
+        .crypt = { 0x47, 0x09, 0xc0, 0x4d, 0x3d, 0xa8, 0x78, 0x06, 0x86, 0x3b, 0x37, 0x21, 0xb4, 0xba, 0xd6, 0x94 },
+    },
+    {
+        .key = { 0xdc, 0x1d, 0x27, 0xe1, 0x46, 0x09, 0x41, 0x46, 0x6a, 0x87, 0x3f, 0xe0, 0x36, 0x0b, 0xeb, 0x3c },
+        .plain = { 0x86, 0x4b, 0xab, 0xb4, 0xcc, 0xb7, 0x9b, 0x03, 0xcb, 0x51, 0x91, 0xe5, 0x3a, 0x39, 0xf4, 0x3a },
+        .crypt = { 0xba, 0x20, 0xf0, 0x0e, 0xe3, 0x33, 0x45, 0xb4, 0x77, 0xc5, 0x48, 0xf3, 0x62, 0x27, 0x16, 0x47 },
+    },
+};
+
+static const struct aes_vector aes192_vectors[] = {
+    {
+        .key = { 0xaa, 0x1f, 0xa7, 0xc1, 0x52, 0xbf, 0x29, 0x18, 0x5d, 0x01, 0x0a, 0xe5, 0xc3, 0x70, 0xdc, 0xe7, 0x3e, 0xa7, 0x4d, 0xb5, 0xaa, 0x66, 0xeb, 0x20 },
+        .plain = { 0x80, 0x49, 0x75, 0xfe, 0xae, 0x26, 0x45, 0x1c, 0x49, 0x45, 0x16, 0xab, 0xc7, 0xdf, 0x31, 0x66 },
+        .crypt = { 0x6d, 0x22, 0x22, 0xa3, 0x9e, 0x6d, 0x20, 0x11, 0x85, 0x00, 0x3e, 0x07, 0x96, 0xb8, 0xac, 0x87 },
+    },
+    {
+        .key = { 0x59, 0x28, 0x3d, 0x83, 0x9a, 0x47, 0x86, 0xe3, 0xa2, 0x28, 0x85, 0xf5, 0x31, 0xa4, 0xec, 0xc7, 0xfa, 0xeb, 0xe2, 0xea, 0x20, 0x9e, 0x05, 0x45 },
+        .plain = { 0xf9, 0xb7, 0x7e, 0x77, 0x2a, 0x7a, 0x2e, 0x98, 0xb2, 0x99, 0x34, 0x6e, 0x10, 0x91, 0x23, 0x2f },
+        .crypt = { 0xb8, 0xd1, 0x6c, 0x4b, 0xd7, 0xf2, 0xe8, 0x4d, 0xee, 0xfd, 0x1a, 0x7b, 0x97, 0xaa, 0x6a, 0x6f },
+    },
+    {
+        .key = { 0xcb, 0x13, 0xa5, 0x21, 0xbe, 0x25, 0xef, 0xfb, 0x97, 0x46, 0x16, 0xa7, 0x76, 0x54, 0xcd, 0xfe, 0xf9, 0x39, 0xe0, 0xb8, 0x1f, 0xaa, 0x08, 0xde },
+        .plain = { 0xb0, 0xff, 0x95, 0xe7, 0x74, 0x94, 0x67, 0x3a, 0x0f, 0x42, 0x7b, 0xaf, 0x69, 0x92, 0x80, 0xb7 },
+        .crypt = { 0x8f, 0x93, 0x1b, 0x62, 0xdb, 0x5f, 0x05, 0x26, 0xc7, 0xdb, 0xa7, 0xc2, 0xa2, 0x12, 0x9a, 0xed },
+    },
+    {
+        .key = { 0xae, 0xda, 0x7e, 0x75, 0xc1, 0xfc, 0x84, 0x3d, 0xdb, 0x44, 0x58, 0x96, 0x5f, 0x56, 0xa2, 0x14, 0x15, 0xa5, 0x6c, 0x8f, 0x34, 0xc2, 0xbf, 0xc1 },
+        .plain = { 0xdd, 0x38, 0x30, 0xe4, 0x9a, 0xfa, 0xc4, 0x91, 0xc2, 0x09, 0x50, 0xcc, 0x67, 0x45, 0xba, 0xcf },
+        .crypt = { 0x5c, 0x19, 0xbc, 0xc0, 0x4d, 0x12, 0x46, 0x21, 0x57, 0x8b, 0xcb, 0xad, 0x50, 0xca, 0x03, 0x36 },
+    },
+};
+
+static const struct aes_vector aes256_vectors[] = {
+    {
+        .key = { 0x5a, 0x18, 0xc5, 0x32, 0x0f, 0x67, 0x57, 0xb0, 0x36, 0xd3, 0xb7, 0x8d, 0x87, 0xa0, 0x9b, 0xc3, 0x74, 0xd6, 0xf6, 0xcf, 0x1c, 0x4a, 0x2c, 0x31, 0x55, 0x21, 0x6b, 0x1d, 0x0d, 0x7f, 0xce, 0x4d },
+        .plain = { 0x14, 0xe5, 0xae, 0x55, 0x05, 0x47, 0x6a, 0xe6, 0x53, 0x68, 0xf7, 0x58, 0xad, 0xde, 0x6c, 0x49 },
+        .crypt = { 0xf7, 0xa2, 0xea, 0xad, 0x24, 0x02, 0x45, 0x14, 0x53, 0x03, 0xd0, 0x25, 0x5d, 0xa5, 0xa8, 0x73 },
+    },
+    {
+        .key = { 0x9e, 0xf2, 0x0b, 0xa5, 0xf4, 0x03, 0xa2, 0x16, 0x58, 0x55, 0xf0, 0x31, 0x13, 0x8b, 0xfd, 0x61, 0x41, 0xc8, 0xc3, 0xe1, 0xee, 0xd1, 0x6c, 0x62, 0x19, 0xd4, 0xb3, 0xba, 0x5a, 0x91, 0x05, 0x47 },
+        .plain = { 0xe0, 0x15, 0x09, 0x16, 0x75, 0x2b, 0xf1, 0xd9, 0xa1, 0xb4, 0x0e, 0x98, 0x0c, 0x16, 0x40, 0x74 },
+        .crypt = { 0x34, 0xc0, 0xaa, 0x34, 0xb5, 0x3e, 0x14, 0xa7, 0x68, 0x23, 0xbd, 0x8e, 0xd0, 0xbb, 0x2d, 0x45 },
+    },
+    {
+        .key = { 0xa2, 0x1d, 0x75, 0xa1, 0x55, 0xed, 0x32, 0x05, 0xd0, 0x1c, 0x0a, 0xe8, 0x7b, 0x3f, 0xe3, 0xbd, 0xcf, 0x6e, 0x8b, 0x24, 0x54, 0xbe, 0x5e, 0x46, 0x69, 0x36, 0xad, 0x3a, 0x47, 0xe1, 0x14, 0x44 },
+        .plain = { 0x61, 0xae, 0x04, 0x69, 0x2c, 0x29, 0xe7, 0x5e, 0x95, 0x04, 0x53, 0x6a, 0x88, 0x44, 0xa3, 0x58 },
+        .crypt = { 0x63, 0xef, 0x68, 0xa0, 0x00, 0x20, 0x1e, 0x50, 0xf8, 0x89, 0xaf, 0x58, 0xb3, 0x25, 0xb9, 0x91 },
+    },
+    {
+        .key = { 0x5a, 0xd0, 0x2f, 0x2f, 0xb6, 0xbc, 0x9e, 0x47, 0xf3, 0xc5, 0xca, 0x9e, 0xaa, 0xfa, 0x04, 0xba, 0x36, 0xab, 0x04, 0x4a, 0x3a, 0x12, 0x73, 0x20, 0xca, 0x97, 0x2e, 0x17, 0x18, 0x6b, 0x74, 0x26 },
+        .plain = { 0x74, 0xaf, 0xdd, 0x2c, 0x4b, 0x07, 0xe6, 0x49, 0x21, 0xdb, 0x9f, 0x75, 0xb9, 0xb2, 0xc0, 0xcd },
+        .crypt = { 0xf1, 0x07, 0x33, 0x8d, 0x79, 0x7e, 0x98, 0xdb, 0x4b, 0xa1, 0x25, 0x83, 0xea, 0xc7, 0xfd, 0xe8 },
+    },
+};
@@ -0,0 +1,276 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Snapshot import/export and allocation table walk on the flash simulator
+ *
+ * The import must only replace the profile once the whole snapshot has
+ * been verified, whatever the chunking of the stream. The walk must see
+ * the latest entry of every record, across sector garbage collection.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/fs/nvs.h>
+#include <string.h>
+
+#include <softsim/snapshot.h>
+
+#include "softsim_internal.h"
+
+#define FILES     6
+#define FILE_REL  0x100
+#define EXTRA_REL 0x200
+#define BLOB_MAX  2048
+
+struct blob {
+    uint8_t data[BLOB_MAX];
+    size_t len;
+};
+
+static struct blob snap;
+
+static uint16_t file_id(unsigned int i)
+{
+    return softsim_storage_id_base() + FILE_REL + i * 7;
+}
+
+static size_t file_len(unsigned int i)
+{
+    return 8 + i * 13;
+}
+
+static void file_content(unsigned int i, uint8_t gen, uint8_t *buf)
+{
+    for (size_t n = 0; n < file_len(i); n++) {
+        buf[n] = gen * 31 + i * 7 + n;
+    }
+}
+
+static void files_write(uint8_t gen)
+{
+    uint8_t buf[128];
+
+    for (unsigned int i = 0; i < FILES; i++) {
+        file_content(i, gen, buf);
+        zassert_equal(softsim_storage_write(file_id(i), buf, file_len(i)), file_len(i));
+    }
+}
+
+static void files_check(uint8_t gen)
+{
+    uint8_t buf[128], ref[128];
+
+    for (unsigned int i = 0; i < FILES; i++) {
+        file_content(i, gen, ref);
+        zassert_equal(softsim_storage_read(file_id(i), buf, sizeof(buf)), file_len(i),
+                      "file %u", i);
+        zassert_mem_equal(buf, ref, file_len(i), "file %u, generation %u", i, gen);
+    }
+}
+
+static int blob_out(const uint8_t *data, size_t len, void *user)
+{
+    struct blob *b = user;
+
+    if (b->len + len > sizeof(b->data)) {
+        return -ENOSPC;
+    }
+    memcpy(&b->data[b->len], data, len);
+    b->len += len;
+
+    return 0;
+}
+
+/* Import data in chunks of the given size, returns import_end() */
+static int import(const uint8_t *data, size_t len, size_t chunk, int *feed_err)
+{
+    struct softsim_snapshot_import *imp = softsim_snapshot_import_begin();
+
+    *feed_err = 0;
+    if (!imp) {
+        return -ENOMEM;
+    }
+
+    for (size_t off = 0; off < len && !*feed_err; off += chunk) {
+        *feed_err = softsim_snapshot_import_feed(imp, &data[off], MIN(chunk, len - off));
+    }
+
+    return softsim_snapshot_import_end(imp);
+}
+
+static void before(void *fixture)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+
+    ARG_UNUSED(fixture);
+
+    zassert_not_null(nvs, "NVS not mounted");
+
+    for (unsigned int i = 0; i < FILES; i++) {
+        nvs_delete(nvs, file_id(i));
+    }
+    nvs_delete(nvs, softsim_storage_id_base() + EXTRA_REL);
+
+    files_write(1);
+    memset(&snap, 0, sizeof(snap));
+    zassert_equal(softsim_snapshot_export(blob_out, &snap), snap.len);
+    files_write(2);
+}
+
+ZTEST(snapshot, test_roundtrip_chunked)
+{
+    static const size_t chunks[] = { 1, 3, 4, 5, 64, BLOB_MAX };
+    uint8_t extra = 0x5a;
+    int feed_err;
+
+    for (size_t c = 0; c < ARRAY_SIZE(chunks); c++) {
+        uint16_t extra_id = softsim_storage_id_base() + EXTRA_REL;
+        int ret;
+
+        files_write(2);
+        zassert_equal(softsim_storage_write(extra_id, &extra, 1), 1);
+
+        ret = import(snap.data, snap.len, chunks[c], &feed_err);
+        zassert_ok(feed_err, "chunk %zu", chunks[c]);
+        zassert_true(ret >= FILES, "chunk %zu: %d", chunks[c], ret);
+        files_check(1);
+
+        /* Not in the snapshot, not in the restored profile */
+        extra_id = softsim_storage_id_base() + EXTRA_REL;
+        zassert_equal(softsim_storage_read(extra_id, NULL, 0), -ENOENT);
+    }
+}
+
+ZTEST(snapshot, test_bad_crc_keeps_profile)
+{
+    static uint8_t bad[BLOB_MAX];
+    uint16_t base = softsim_storage_id_base();
+    int feed_err;
+
+    memcpy(bad, snap.data, snap.len);
+    bad[snap.len / 2] ^= 0x01;
+
+    zassert_equal(import(bad, snap.len, 16, &feed_err), -EBADMSG);
+    zassert_equal(softsim_storage_id_base(), base);
+    files_check(2);
+}
+
+ZTEST(snapshot, test_truncated_keeps_profile)
+{
+    int feed_err;
+
+    zassert_equal(import(snap.data, snap.len - 3, 7, &feed_err), -EBADMSG);
+    zassert_ok(feed_err);
+    files_check(2);
+}
+
+ZTEST(snapshot, test_trailing_bytes)
+{
+    static uint8_t longer[BLOB_MAX + 1];
+    int feed_err;
+
+    memcpy(longer, snap.data, snap.len);
+    zassert_equal(import(longer, snap.len + 1, snap.len + 1, &feed_err), -EBADMSG);
+    zassert_equal(feed_err, -EBADMSG);
+    files_check(2);
+}
+
+ZTEST(snapshot, test_bad_header)
+{
+    static uint8_t bad[BLOB_MAX];
+    int feed_err;
+
+    memcpy(bad, snap.data, snap.len);
+    bad[0] = 'X';
+
+    zassert_equal(import(bad, snap.len, snap.len, &feed_err), -EBADMSG);
+    zassert_equal(feed_err, -EBADMSG);
+    files_check(2);
+}
+
+struct walk {
+    uint16_t base;
+    ssize_t len[FILES];        /* Latest entry, -1 if none */
+    unsigned int entries;
+};
+
+static int walk_cb(uint16_t id, uint32_t addr, uint16_t len, void *arg)
+{
+    struct walk *w = arg;
+
+    ARG_UNUSED(addr);
+
+    for (unsigned int i = 0; i < FILES; i++) {
+        if (id == w->base + FILE_REL + i * 7) {
+            w->len[i] = len;
+        }
+    }
+    w->entries++;
+
+    return 0;
+}
+
+static int walk_stop_cb(uint16_t id, uint32_t addr, uint16_t len, void *arg)
+{
+    unsigned int *calls = arg;
+
+    ARG_UNUSED(id);
+    ARG_UNUSED(addr);
+    ARG_UNUSED(len);
+
+    return ++(*calls) == 3 ? 1 : 0;
+}
+
+static void walk(struct walk *w)
+{
+    memset(w, 0, sizeof(*w));
+    w->base = softsim_storage_id_base();
+    for (unsigned int i = 0; i < FILES; i++) {
+        w->len[i] = -1;
+    }
+    zassert_ok(softsim_storage_ate_walk(walk_cb, w));
+}
+
+ZTEST(snapshot, test_walk_latest_entry)
+{
+    struct walk w;
+
+    zassert_ok(nvs_delete(softsim_storage_nvs(), file_id(0)));
+
+    walk(&w);
+    zassert_equal(w.len[0], 0, "deletion not seen last");
+    for (unsigned int i = 1; i < FILES; i++) {
+        zassert_equal(w.len[i], file_len(i), "file %u", i);
+    }
+}
+
+ZTEST(snapshot, test_walk_across_gc)
+{
+    struct nvs_fs *nvs = softsim_storage_nvs();
+    uint8_t buf[96];
+    struct walk w;
+
+    /* Enough rewrites of one file to go through every sector */
+    memset(buf, 0xa5, sizeof(buf));
+    for (unsigned int n = 0; n < 2 * nvs->sector_count * nvs->sector_size / sizeof(buf); n++) {
+        buf[0] = n;
+        zassert_equal(softsim_storage_write(file_id(0), buf, sizeof(buf)), sizeof(buf));
+    }
+
+    walk(&w);
+    zassert_equal(w.len[0], sizeof(buf));
+    for (unsigned int i = 1; i < FILES; i++) {
+        zassert_equal(w.len[i], file_len(i), "file %u lost by the walk", i);
+    }
+}
+
+ZTEST(snapshot, test_walk_stop)
+{
+    unsigned int calls = 0;
+
+    zassert_ok(softsim_storage_ate_walk(walk_stop_cb, &calls));
+    zassert_equal(calls, 3);
+}
+
+ZTEST_SUITE(snapshot, NULL, NULL, before, NULL, NULL);
@@ -0,0 +1,176 @@
+/*
+ * SPDX-License-Identifier: AGPL-3.0-only
+ *
+ * Copyright (c) 2025 Vincent Jardin <vjardin@free.fr>, Free Mobile
+ *
+ * Delta encoding of the SQN file
+ *
+ * A delta applied to its base must give back the content it was built
+ * from, and a malformed delta must be rejected before anything is
+ * patched.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <errno.h>
+#include <string.h>
+
+#include "sqn_delta.h"
+
+/* 32 SQN entries of 6 bytes, as kept by MILENAGE */
+#define SQN_LEN   192
+#define DELTA_MAX 256
+
+static uint8_t base[SQN_LEN];
+static uint8_t cur[SQN_LEN];
+static uint8_t delta[DELTA_MAX];
+
+/* Reproducible pseudo-random content */
+static uint32_t rand_next(void)
+{
+    static uint32_t x = 0x2545f491;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    for (size_t i = 0; i < SQN_LEN; i++) {
+        base[i] = i * 7;
+    }
+    memcpy(cur, base, SQN_LEN);
+    memset(delta, 0, sizeof(delta));
+}
+
+/* Build, then apply to a copy of the base, which must become cur */
+static int roundtrip(size_t max)
+{
+    uint8_t buf[SQN_LEN];
+    int n;
+
+    n = sqn_delta_build(base, cur, SQN_LEN, delta, max);
+    if (n < 0) {
+        return n;
+    }
+
+    memcpy(buf, base, SQN_LEN);
+    if (!sqn_delta_walk(delta, n, buf, SQN_LEN, true) || memcmp(buf, cur, SQN_LEN)) {
+        return -EBADMSG;
+    }
+    return n;
+}
+
+ZTEST(sqn_delta, test_unchanged)
+{
+    zassert_equal(roundtrip(DELTA_MAX), SQN_DELTA_HDR_LEN);
+    zassert_equal(sqn_delta_base_crc(delta), crc32_ieee(base, SQN_LEN));
+}
+
+ZTEST(sqn_delta, test_one_entry)
+{
+    /* An authentication updates the SQN of one index */
+    sys_put_be32(0x01020304, &cur[6 * 5 + 2]);
+
+    zassert_equal(roundtrip(DELTA_MAX), SQN_DELTA_HDR_LEN + SQN_DELTA_ENTRY_HDR + 4);
+    zassert_equal(sys_get_le16(&delta[SQN_DELTA_HDR_LEN]), 6 * 5 + 2);
+    zassert_equal(delta[SQN_DELTA_HDR_LEN + 2], 4);
+}
+
+ZTEST(sqn_delta, test_close_runs_merge)
+{
+    /* Two equal bytes between the changes cost less than an entry header */
+    cur[10] ^= 0xff;
+    cur[13] ^= 0xff;
+
+    zassert_equal(roundtrip(DELTA_MAX), SQN_DELTA_HDR_LEN + SQN_DELTA_ENTRY_HDR + 4);
+}
+
+ZTEST(sqn_delta, test_far_runs_split)
+{
+    cur[10] ^= 0xff;
+    cur[100] ^= 0xff;
+
+    zassert_equal(roundtrip(DELTA_MAX), SQN_DELTA_HDR_LEN + 2 * (SQN_DELTA_ENTRY_HDR + 1));
+}
+
+ZTEST(sqn_delta, test_long_run)
+{
+    static uint8_t lbase[600];
+    static uint8_t lcur[600];
+    static uint8_t ldelta[700];
+    uint8_t buf[600];
+    int n;
+
+    /* Runs are at most 255 bytes */
+    memset(lbase, 0, sizeof(lbase));
+    memset(lcur, 0xa5, sizeof(lcur));
+
+    n = sqn_delta_build(lbase, lcur, sizeof(lbase), ldelta, sizeof(ldelta));
+    zassert_equal(n, SQN_DELTA_HDR_LEN + 3 * SQN_DELTA_ENTRY_HDR + sizeof(lcur));
+
+    memcpy(buf, lbase, sizeof(buf));
+    zassert_true(sqn_delta_walk(ldelta, n, buf, sizeof(buf), true));
+    zassert_mem_equal(buf, lcur, sizeof(buf));
+}
+
+ZTEST(sqn_delta, test_no_space)
+{
+    for (size_t i = 0; i < SQN_LEN; i += 6) {
+        cur[i] ^= 0xff;
+    }
+
+    zassert_equal(roundtrip(64), -ENOSPC);
+    zassert_true(roundtrip(DELTA_MAX) > 64);
+    zassert_equal(sqn_delta_build(base, cur, SQN_LEN, delta, 2), -ENOSPC);
+}
+
+ZTEST(sqn_delta, test_random)
+{
+    for (int round = 0; round < 200; round++) {
+        size_t index = rand_next() % (SQN_LEN / 6);
+
+        for (size_t i = 0; i < 6; i++) {
+            cur[index * 6 + i] = rand_next();
+        }
+        if (roundtrip(DELTA_MAX) < 0) {
+            /* Full: the content becomes the base, as fs_sqn.c does */
+            memcpy(base, cur, SQN_LEN);
+        }
+        zassert_true(roundtrip(DELTA_MAX) >= SQN_DELTA_HDR_LEN, "round %d", round);
+    }
+}
+
+ZTEST(sqn_delta, test_malformed)
+{
+    uint8_t buf[SQN_LEN];
+    int n;
+
+    cur[20] ^= 0xff;
+    n = sqn_delta_build(base, cur, SQN_LEN, delta, DELTA_MAX);
+    zassert_equal(n, SQN_DELTA_HDR_LEN + SQN_DELTA_ENTRY_HDR + 1);
+    memcpy(buf, base, SQN_LEN);
+
+    /* Truncated entry header, truncated data */
+    zassert_false(sqn_delta_walk(delta, SQN_DELTA_HDR_LEN + 2, buf, SQN_LEN, false));
+    zassert_false(sqn_delta_walk(delta, n - 1, buf, SQN_LEN, false));
+
+    /* Past the end of the file */
+    zassert_false(sqn_delta_walk(delta, n, buf, 20, false));
+    sys_put_le16(SQN_LEN, &delta[SQN_DELTA_HDR_LEN]);
+    zassert_false(sqn_delta_walk(delta, n, buf, SQN_LEN, false));
+
+    /* Empty run */
+    sys_put_le16(20, &delta[SQN_DELTA_HDR_LEN]);
+    delta[SQN_DELTA_HDR_LEN + 2] = 0;
+    zassert_false(sqn_delta_walk(delta, n, buf, SQN_LEN, true));
+
+    zassert_mem_equal(buf, base, SQN_LEN, "patched by a rejected delta");
+}
+
+ZTEST_SUITE(sqn_delta, NULL, NULL, before, NULL, NULL);